@@ -0,0 +1,236 @@
+#include "XCEPBENCH_bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XCEPTEST_thread.h"
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <time.h>
+	#include <unistd.h>
+#endif
+
+const XCEPBENCH_t_Options* XCEPBENCH_g_Options = NULL;
+volatile long XCEPBENCH_g_Sink = 0;
+
+// =========================================================
+// MARK: Platform
+// =========================================================
+
+uint64_t XCEPBENCH_NowNs(void) {
+#if defined(_WIN32)
+	static LARGE_INTEGER sFrequency = { 0 };
+	LARGE_INTEGER vCounter;
+	if (sFrequency.QuadPart == 0) QueryPerformanceFrequency(&sFrequency);
+	QueryPerformanceCounter(&vCounter);
+	return (uint64_t)((double)vCounter.QuadPart * 1e9 / (double)sFrequency.QuadPart);
+#else
+	struct timespec vNow;
+	clock_gettime(CLOCK_MONOTONIC, &vNow);
+	return (uint64_t)vNow.tv_sec * 1000000000ull + (uint64_t)vNow.tv_nsec;
+#endif
+}
+
+int XCEPBENCH_CpuCount(void) {
+#if defined(_WIN32)
+	SYSTEM_INFO vInfo;
+	GetSystemInfo(&vInfo);
+	return (int)vInfo.dwNumberOfProcessors;
+#else
+	const long vCount = sysconf(_SC_NPROCESSORS_ONLN);
+	return vCount > 0 ? (int)vCount : 1;
+#endif
+}
+
+#if defined(_MSC_VER)
+	#define XCEPBENCH_ATOMIC_INC(_ptr) InterlockedIncrement((volatile LONG*)(_ptr))
+	#define XCEPBENCH_ATOMIC_LOAD(_ptr) InterlockedCompareExchange((volatile LONG*)(_ptr), 0, 0)
+	#define XCEPBENCH_ATOMIC_STORE(_ptr, _val) InterlockedExchange((volatile LONG*)(_ptr), (_val))
+#else
+	#define XCEPBENCH_ATOMIC_INC(_ptr) __atomic_add_fetch((_ptr), 1, __ATOMIC_ACQ_REL)
+	#define XCEPBENCH_ATOMIC_LOAD(_ptr) __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+	#define XCEPBENCH_ATOMIC_STORE(_ptr, _val) __atomic_store_n((_ptr), (_val), __ATOMIC_RELEASE)
+#endif
+
+// =========================================================
+// MARK: Filter
+// =========================================================
+
+int XCEPBENCH_Enabled(const char* inSuite, const char* inName) {
+	const char* vFilter = XCEPBENCH_g_Options->filter;
+	if (vFilter == NULL || vFilter[0] == '\0') return 1;
+
+	char vFullName[256];
+	snprintf(vFullName, sizeof(vFullName), "%s/%s", inSuite, inName);
+	return strstr(vFullName, vFilter) != NULL;
+}
+
+// =========================================================
+// MARK: Single Thread
+// =========================================================
+
+void XCEPBENCH_Run(const char* inSuite, const char* inName, const int inParam, const XCEPBENCH_t_Func inFunc) {
+	if (!XCEPBENCH_Enabled(inSuite, inName)) return;
+
+	const uint64_t vMinTimeNs = (uint64_t)XCEPBENCH_g_Options->min_time_ms * 1000000ull;
+
+	// Warm up caches and the branch predictor before calibrating
+	inFunc(64, inParam);
+
+	long vIterations = 64;
+	uint64_t vElapsed = 0;
+	for (;;) {
+		const uint64_t vStart = XCEPBENCH_NowNs();
+		inFunc(vIterations, inParam);
+		vElapsed = XCEPBENCH_NowNs() - vStart;
+		if (vElapsed >= vMinTimeNs || vIterations >= (1L << 30)) break;
+		vIterations *= 2;
+	}
+
+	const XCEPBENCH_t_Result vResult = {
+		.config = XCEPBENCH_CONFIG,
+		.suite = inSuite,
+		.name = inName,
+		.param = inParam,
+		.threads = 1,
+		.iterations = vIterations,
+		.ns_per_op = (double)vElapsed / (double)vIterations,
+		.ops_per_sec = (double)vIterations * 1e9 / (double)(vElapsed ? vElapsed : 1),
+	};
+	XCEPBENCH_Report(&vResult);
+}
+
+// =========================================================
+// MARK: Multi Thread
+// =========================================================
+
+typedef struct {
+	XCEPBENCH_t_Func func;
+	int param;
+	long iterations;
+	volatile long ready;
+	volatile long go;
+} XCEPBENCH_t_ThreadShared;
+
+#if defined(_WIN32)
+static DWORD WINAPI XCEPBENCH_ThreadMain(LPVOID inArg) {
+#else
+static void* XCEPBENCH_ThreadMain(void* inArg) {
+#endif
+	XCEPBENCH_t_ThreadShared* vShared = inArg;
+
+	XCEPBENCH_ATOMIC_INC(&vShared->ready);
+	while (XCEPBENCH_ATOMIC_LOAD(&vShared->go) == 0) { }
+
+	vShared->func(vShared->iterations, vShared->param);
+
+#if defined(_WIN32)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+void XCEPBENCH_RunThreaded(const char* inSuite, const char* inName, const int inParam, const int inThreads, const XCEPBENCH_t_Func inFunc) {
+	if (!XCEPBENCH_Enabled(inSuite, inName)) return;
+
+	XCEPTEST_t_Thread* vThreads = malloc(sizeof(XCEPTEST_t_Thread) * (size_t)inThreads);
+	if (vThreads == NULL) {
+		fprintf(stderr, "Failed to allocate %d threads for %s/%s\n", inThreads, inSuite, inName);
+		return;
+	}
+
+	XCEPBENCH_t_ThreadShared vShared = {
+		.func = inFunc,
+		.param = inParam,
+		.iterations = XCEPBENCH_g_Options->thread_iterations,
+		.ready = 0,
+		.go = 0,
+	};
+
+	int vStarted = 0;
+	for (; vStarted < inThreads; ++vStarted) {
+		if (XCEPTEST_ThreadCreate(&vThreads[vStarted], XCEPBENCH_ThreadMain, &vShared) != 0) {
+			fprintf(stderr, "Failed to create thread %d for %s/%s\n", vStarted, inSuite, inName);
+			break;
+		}
+	}
+
+	while (XCEPBENCH_ATOMIC_LOAD(&vShared.ready) < vStarted) { }
+
+	const uint64_t vStart = XCEPBENCH_NowNs();
+	XCEPBENCH_ATOMIC_STORE(&vShared.go, 1);
+	for (int i = 0; i < vStarted; ++i) { XCEPTEST_ThreadJoin(vThreads[i]); }
+	const uint64_t vElapsed = XCEPBENCH_NowNs() - vStart;
+
+	free(vThreads);
+	if (vStarted != inThreads) return;
+
+	const double vTotalOps = (double)vShared.iterations * (double)inThreads;
+	const XCEPBENCH_t_Result vResult = {
+		.config = XCEPBENCH_CONFIG,
+		.suite = inSuite,
+		.name = inName,
+		.param = inParam,
+		.threads = inThreads,
+		.iterations = vShared.iterations,
+		.ns_per_op = (double)vElapsed * (double)inThreads / vTotalOps,
+		.ops_per_sec = vTotalOps * 1e9 / (double)(vElapsed ? vElapsed : 1),
+	};
+	XCEPBENCH_Report(&vResult);
+}
+
+// =========================================================
+// MARK: Report
+// =========================================================
+
+static int XCEPBENCH_g_ReportCount = 0;
+
+void XCEPBENCH_ReportBegin(void) {
+	switch (XCEPBENCH_g_Options->format) {
+		case XCEPBENCH_FORMAT_TABLE:
+			printf("# config=%s sizeof(XCEP_t_Frame)=%u\n", XCEPBENCH_CONFIG, XCEPBENCH_FrameSize());
+			printf("%-10s %-28s %6s %8s %12s %12s %14s\n", "suite", "name", "param", "threads", "iterations", "ns/op", "ops/s");
+			break;
+		case XCEPBENCH_FORMAT_CSV:
+			printf("config,suite,name,param,threads,iterations,ns_per_op,ops_per_sec\n");
+			break;
+		case XCEPBENCH_FORMAT_JSON:
+			printf("{\n  \"config\": \"%s\",\n  \"frame_size\": %u,\n  \"results\": [", XCEPBENCH_CONFIG, XCEPBENCH_FrameSize());
+			break;
+	}
+	fflush(stdout);
+}
+
+void XCEPBENCH_Report(const XCEPBENCH_t_Result* inResult) {
+	switch (XCEPBENCH_g_Options->format) {
+		case XCEPBENCH_FORMAT_TABLE:
+			printf("%-10s %-28s %6d %8d %12ld %12.2f %14.0f\n",
+				inResult->suite, inResult->name, inResult->param, inResult->threads,
+				inResult->iterations, inResult->ns_per_op, inResult->ops_per_sec);
+			break;
+		case XCEPBENCH_FORMAT_CSV:
+			printf("%s,%s,%s,%d,%d,%ld,%.3f,%.0f\n",
+				inResult->config, inResult->suite, inResult->name, inResult->param, inResult->threads,
+				inResult->iterations, inResult->ns_per_op, inResult->ops_per_sec);
+			break;
+		case XCEPBENCH_FORMAT_JSON:
+			printf("%s\n    {\"config\": \"%s\", \"suite\": \"%s\", \"name\": \"%s\", \"param\": %d, \"threads\": %d, \"iterations\": %ld, \"ns_per_op\": %.3f, \"ops_per_sec\": %.0f}",
+				XCEPBENCH_g_ReportCount ? "," : "",
+				inResult->config, inResult->suite, inResult->name, inResult->param, inResult->threads,
+				inResult->iterations, inResult->ns_per_op, inResult->ops_per_sec);
+			break;
+	}
+	XCEPBENCH_g_ReportCount++;
+	fflush(stdout);
+}
+
+void XCEPBENCH_ReportEnd(void) {
+	if (XCEPBENCH_g_Options->format == XCEPBENCH_FORMAT_JSON) {
+		printf("\n  ]\n}\n");
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,87 @@
+#ifndef XCEPBENCH_BENCH_H
+#define XCEPBENCH_BENCH_H
+
+#include <stdint.h>
+
+// =========================================================
+// MARK: Attributes
+// =========================================================
+
+#if defined(_MSC_VER)
+	#define XCEPBENCH_NOINLINE __declspec(noinline)
+#elif defined(__clang__) || defined(__GNUC__)
+	#define XCEPBENCH_NOINLINE __attribute__((noinline))
+#else
+	#define XCEPBENCH_NOINLINE
+#endif
+
+#ifndef XCEPBENCH_CONFIG
+	#define XCEPBENCH_CONFIG "default"
+#endif
+
+// =========================================================
+// MARK: Types
+// =========================================================
+
+typedef enum {
+	XCEPBENCH_FORMAT_TABLE,
+	XCEPBENCH_FORMAT_CSV,
+	XCEPBENCH_FORMAT_JSON
+} XCEPBENCH_t_Format;
+
+typedef struct {
+	XCEPBENCH_t_Format format;
+	const char* filter;      // Only run benchmarks whose "suite/name" contains this
+	int max_threads;         // Upper bound for the throughput mode
+	int min_time_ms;         // Calibration target per single-threaded measurement
+	long thread_iterations;  // Iterations run by every thread in throughput mode
+} XCEPBENCH_t_Options;
+
+typedef struct {
+	const char* config;
+	const char* suite;
+	const char* name;
+	int param;
+	int threads;
+	long iterations;
+	double ns_per_op;
+	double ops_per_sec;
+} XCEPBENCH_t_Result;
+
+// Runs `iterations` times the measured operation with `param` (depth, chain length...)
+typedef void (*XCEPBENCH_t_Func)(long iterations, int param);
+
+// =========================================================
+// MARK: Globals
+// =========================================================
+
+extern const XCEPBENCH_t_Options* XCEPBENCH_g_Options;
+extern volatile long XCEPBENCH_g_Sink;
+
+// =========================================================
+// MARK: Functions
+// =========================================================
+
+uint64_t XCEPBENCH_NowNs(void);
+unsigned XCEPBENCH_FrameSize(void);
+int XCEPBENCH_CpuCount(void);
+
+int XCEPBENCH_Enabled(const char* inSuite, const char* inName);
+
+// Calibrates the iteration count until a run lasts at least `min_time_ms` and reports it
+void XCEPBENCH_Run(const char* inSuite, const char* inName, int inParam, XCEPBENCH_t_Func inFunc);
+
+// Runs `inFunc` on `inThreads` threads at once and reports the aggregated throughput
+void XCEPBENCH_RunThreaded(const char* inSuite, const char* inName, int inParam, int inThreads, XCEPBENCH_t_Func inFunc);
+
+void XCEPBENCH_Report(const XCEPBENCH_t_Result* inResult);
+void XCEPBENCH_ReportBegin(void);
+void XCEPBENCH_ReportEnd(void);
+
+// =========================================================
+// MARK: Suites
+// =========================================================
+
+void XCEPBENCH_SuiteCore(void);
+
+#endif //XCEPBENCH_BENCH_H
@@ -0,0 +1,9 @@
+# cmake -DNM=<nm> -DLIBRARY=<shared object> -P XCEPBENCH_check_tls.cmake
+# Fails when the shared object still calls __tls_get_addr, the initial-exec model was not applied
+execute_process(COMMAND ${NM} -D --undefined-only ${LIBRARY} OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Cannot list the symbols of ${LIBRARY}")
+endif()
+if(symbols MATCHES "__tls_get_addr")
+    message(FATAL_ERROR "${LIBRARY} is built with XCEP_CONF_TLS_MODEL=2 but still imports __tls_get_addr")
+endif()
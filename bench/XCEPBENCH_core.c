@@ -0,0 +1,814 @@
+#include "XCEPBENCH_bench.h"
+#include "XCEPTEST_random.h"
+
+#define XCEP_IMPLEMENTATION
+#include <XCEP.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// =========================================================
+// MARK: Exception Codes
+// =========================================================
+
+enum XCEPBENCH_ExceptionCodes {
+	XCEPBENCH_ERR_BENCH = 1,
+	XCEPBENCH_ERR_OTHER = 2
+};
+
+#define XCEPBENCH_SUITE_CORE "core"
+
+// =========================================================
+// MARK: Try/EndTry entry and exit, no throw
+// =========================================================
+
+static void bench_try_no_throw(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+static void bench_try_finally_no_throw(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			XCEPBENCH_g_Sink++;
+		}
+		CatchAll {
+			XCEPBENCH_g_Sink--;
+		}
+		Finally {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+// Baseline: the same guarded work checked through a return code
+static XCEPBENCH_NOINLINE int errcode_no_error(void) {
+	XCEPBENCH_g_Sink++;
+	return 0;
+}
+
+static void bench_errcode_no_error(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (long i = 0; i < inIterations; ++i) {
+		if (errcode_no_error() != 0) {
+			XCEPBENCH_g_Sink--;
+		}
+	}
+}
+
+// =========================================================
+// MARK: Cached context (one TLS lookup per loop instead of per Try/Throw)
+// =========================================================
+
+static void bench_try_ctx_no_throw(const long inIterations, const int inParam) {
+	(void)inParam;
+	XCEP_t_Context* vContext = XCEP_GetContext();
+	for (volatile long i = 0; i < inIterations; ++i) {
+		TryCtx(vContext) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+static void bench_throw_catch(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+static void bench_throw_catch_ctx(const long inIterations, const int inParam) {
+	(void)inParam;
+	XCEP_t_Context* vContext = XCEP_GetContext();
+	for (volatile long i = 0; i < inIterations; ++i) {
+		TryCtx(vContext) {
+			ThrowCtx(vContext, XCEPBENCH_ERR_BENCH, "bench");
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+#if XCEP_CONF_PAYLOAD_SIZE
+typedef struct {
+	long offset;
+	int error_number;
+	char token[16];
+} XCEPBENCH_t_Payload;
+
+static void bench_throw_catch_payload(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			ThrowWith(XCEPBENCH_ERR_BENCH, "bench", ((XCEPBENCH_t_Payload){ i, 22, "token" }));
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink += CaughtPayload(XCEPBENCH_t_Payload)->offset;
+		}
+		EndTry;
+	}
+}
+#endif
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+static void bench_throw_catch_formatted(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			ThrowF(XCEPBENCH_ERR_BENCH, "bench %ld at %s", i, "bench.c");
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+#endif
+
+// =========================================================
+// MARK: Throw to Catch through plain call frames
+// =========================================================
+
+static XCEPBENCH_NOINLINE void throw_at_call_depth(const int inDepth) {
+	if (inDepth > 1) {
+		throw_at_call_depth(inDepth - 1);
+	} else if (inDepth == 1) {
+		Throw(XCEPBENCH_ERR_BENCH, "bench");
+	}
+	XCEPBENCH_g_Sink++;
+}
+
+static void bench_throw_call_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			throw_at_call_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+static XCEPBENCH_NOINLINE int errcode_at_call_depth(const int inDepth) {
+	if (inDepth <= 1) {
+		return XCEPBENCH_ERR_BENCH;
+	}
+	const int vResult = errcode_at_call_depth(inDepth - 1);
+	if (vResult != 0) return vResult;
+	XCEPBENCH_g_Sink++;
+	return 0;
+}
+
+static void bench_errcode_call_depth(const long inIterations, const int inParam) {
+	for (long i = 0; i < inIterations; ++i) {
+		if (errcode_at_call_depth(inParam) == XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+	}
+}
+
+// =========================================================
+// MARK: Throw to Catch through nested Try/Finally frames
+// =========================================================
+
+static XCEPBENCH_NOINLINE void throw_at_try_depth(const int inDepth) {
+	Try {
+		if (inDepth <= 1) {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		throw_at_try_depth(inDepth - 1);
+	}
+	Finally {
+		XCEPBENCH_g_Sink++;
+	}
+	EndTry;
+}
+
+static void bench_throw_try_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			throw_at_try_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+// =========================================================
+// MARK: Throw to Catch through N frames holding a deferred cleanup each
+// =========================================================
+
+#if XCEP_CONF_ENABLE_DEFER
+
+static void release_noop(void* inArg) {
+	(void)inArg;
+	XCEPBENCH_g_Sink++;
+}
+
+static XCEPBENCH_NOINLINE void throw_at_defer_depth(const int inDepth) {
+	Defer(release_noop, NULL);
+	if (inDepth > 1) {
+		throw_at_defer_depth(inDepth - 1);
+	} else if (inDepth == 1) {
+		Throw(XCEPBENCH_ERR_BENCH, "bench");
+	}
+	DeferRelease();
+}
+
+static void bench_throw_defer_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			throw_at_defer_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+static void bench_defer_release(const long inIterations, const int inParam) {
+	(void)inParam;
+	for (long i = 0; i < inIterations; ++i) {
+		Defer(release_noop, NULL);
+		DeferRelease();
+	}
+}
+
+#endif
+
+// =========================================================
+// MARK: Rethrow propagation through N Catch frames
+// =========================================================
+
+static XCEPBENCH_NOINLINE void rethrow_at_depth(const int inDepth) {
+	Try {
+		if (inDepth <= 1) {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		rethrow_at_depth(inDepth - 1);
+	}
+	CatchAll {
+		Rethrow;
+	}
+	EndTry;
+}
+
+static void bench_rethrow_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			rethrow_at_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+#if XCEP_CONF_CAUSE_DEPTH
+
+// =========================================================
+// MARK: Every level of N catching and throwing its own exception, caused by the one it caught
+// =========================================================
+
+static XCEPBENCH_NOINLINE void wrap_at_depth(const int inDepth) {
+	Try {
+		if (inDepth <= 1) {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		wrap_at_depth(inDepth - 1);
+	}
+	CatchAll {
+		ThrowWithCause(XCEPBENCH_ERR_BENCH, "wrapped");
+	}
+	EndTry;
+}
+
+static void bench_wrap_cause_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			wrap_at_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+#endif
+
+// =========================================================
+// MARK: Throw to Catch through N frames catching another code, landed in or passed over
+// =========================================================
+
+static XCEPBENCH_NOINLINE void throw_at_catch_other_depth(const int inDepth) {
+	Try {
+		if (inDepth <= 1) {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		throw_at_catch_other_depth(inDepth - 1);
+	}
+	Catch(XCEPBENCH_ERR_OTHER) {
+		XCEPBENCH_g_Sink++;
+	}
+	EndTry;
+}
+
+static void bench_throw_catch_other_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			throw_at_catch_other_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+
+static XCEPBENCH_NOINLINE void throw_at_filter_depth(const int inDepth) {
+	TryFilter(FilterCodes(XCEPBENCH_ERR_OTHER)) {
+		if (inDepth <= 1) {
+			Throw(XCEPBENCH_ERR_BENCH, "bench");
+		}
+		throw_at_filter_depth(inDepth - 1);
+	}
+	Catch(XCEPBENCH_ERR_OTHER) {
+		XCEPBENCH_g_Sink++;
+	}
+	EndTry;
+}
+
+static void bench_throw_filter_depth(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			throw_at_filter_depth(inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+	}
+}
+
+#endif
+
+// =========================================================
+// MARK: Catch chain length (the last clause matches)
+// =========================================================
+
+#define XCEPBENCH_CATCH_1(_code) Catch(_code) { XCEPBENCH_g_Sink++; }
+#define XCEPBENCH_CATCH_2(_code) XCEPBENCH_CATCH_1(_code) XCEPBENCH_CATCH_1((_code) + 1)
+#define XCEPBENCH_CATCH_4(_code) XCEPBENCH_CATCH_2(_code) XCEPBENCH_CATCH_2((_code) + 2)
+#define XCEPBENCH_CATCH_8(_code) XCEPBENCH_CATCH_4(_code) XCEPBENCH_CATCH_4((_code) + 4)
+#define XCEPBENCH_CATCH_16(_code) XCEPBENCH_CATCH_8(_code) XCEPBENCH_CATCH_8((_code) + 8)
+#define XCEPBENCH_CATCH_32(_code) XCEPBENCH_CATCH_16(_code) XCEPBENCH_CATCH_16((_code) + 16)
+#define XCEPBENCH_CATCH_64(_code) XCEPBENCH_CATCH_32(_code) XCEPBENCH_CATCH_32((_code) + 32)
+
+#define XCEPBENCH_DEFINE_CATCH_CHAIN(_length) \
+	static void bench_catch_chain_##_length(const long inIterations, const int inParam) { \
+		(void)inParam; \
+		for (volatile long i = 0; i < inIterations; ++i) { \
+			Try { \
+				Throw(_length, "bench"); \
+			} \
+			XCEPBENCH_CATCH_##_length(1) \
+			EndTry; \
+		} \
+	}
+
+XCEPBENCH_DEFINE_CATCH_CHAIN(1)
+XCEPBENCH_DEFINE_CATCH_CHAIN(2)
+XCEPBENCH_DEFINE_CATCH_CHAIN(4)
+XCEPBENCH_DEFINE_CATCH_CHAIN(8)
+XCEPBENCH_DEFINE_CATCH_CHAIN(16)
+XCEPBENCH_DEFINE_CATCH_CHAIN(32)
+XCEPBENCH_DEFINE_CATCH_CHAIN(64)
+
+// =========================================================
+// MARK: CatchAny over N codes (the last code matches), CatchRange
+// =========================================================
+
+#define XCEPBENCH_CODES_4(_code) (_code), (_code) + 1, (_code) + 2, (_code) + 3
+#define XCEPBENCH_CODES_16(_code) XCEPBENCH_CODES_4(_code), XCEPBENCH_CODES_4((_code) + 4), XCEPBENCH_CODES_4((_code) + 8), XCEPBENCH_CODES_4((_code) + 12)
+#define XCEPBENCH_CODES_64(_code) XCEPBENCH_CODES_16(_code), XCEPBENCH_CODES_16((_code) + 16), XCEPBENCH_CODES_16((_code) + 32), XCEPBENCH_CODES_16((_code) + 48)
+
+#define XCEPBENCH_DEFINE_CATCH_ANY(_count) \
+	static void bench_catch_any_##_count(const long inIterations, const int inParam) { \
+		(void)inParam; \
+		for (volatile long i = 0; i < inIterations; ++i) { \
+			Try { \
+				Throw(_count, "bench"); \
+			} \
+			CatchAny(XCEPBENCH_CODES_##_count(1)) { XCEPBENCH_g_Sink++; } \
+			EndTry; \
+		} \
+	} \
+	static void bench_catch_in_##_count(const long inIterations, const int inParam) { \
+		static const XCEP_t_Int kCodes[] = { XCEPBENCH_CODES_##_count(1) }; \
+		(void)inParam; \
+		for (volatile long i = 0; i < inIterations; ++i) { \
+			Try { \
+				Throw(_count, "bench"); \
+			} \
+			CatchIn(kCodes, _count) { XCEPBENCH_g_Sink++; } \
+			EndTry; \
+		} \
+	}
+
+XCEPBENCH_DEFINE_CATCH_ANY(4)
+XCEPBENCH_DEFINE_CATCH_ANY(16)
+XCEPBENCH_DEFINE_CATCH_ANY(64)
+
+static void bench_catch_range(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			Throw(inParam, "bench");
+		}
+		CatchRange(1, inParam) { XCEPBENCH_g_Sink++; }
+		EndTry;
+	}
+}
+
+static XCEPBENCH_NOINLINE int errcode_switch(const int inCode) {
+	return inCode;
+}
+
+static void bench_errcode_dispatch(const long inIterations, const int inParam) {
+	for (long i = 0; i < inIterations; ++i) {
+		const int vCode = errcode_switch(inParam);
+		for (int c = 1; c <= inParam; ++c) {
+			if (vCode == c) { XCEPBENCH_g_Sink++; break; }
+		}
+	}
+}
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+
+// =========================================================
+// MARK: CatchType, leaf thrown and caught by the ancestor `param` levels up
+// =========================================================
+
+XCEP_DEFINE_TYPE(BenchLevel1, Exception);
+XCEP_DEFINE_TYPE(BenchLevel2, BenchLevel1);
+XCEP_DEFINE_TYPE(BenchLevel3, BenchLevel2);
+XCEP_DEFINE_TYPE(BenchLevel4, BenchLevel3);
+XCEP_DEFINE_TYPE(BenchLevel5, BenchLevel4);
+XCEP_DEFINE_TYPE(BenchLevel6, BenchLevel5);
+XCEP_DEFINE_TYPE(BenchLevel7, BenchLevel6);
+
+#define XCEPBENCH_DEFINE_CATCH_TYPE(_distance, _ancestor) \
+	static void bench_catch_type_##_distance(const long inIterations, const int inParam) { \
+		(void)inParam; \
+		for (volatile long i = 0; i < inIterations; ++i) { \
+			Try { \
+				ThrowType(BenchLevel7, "bench"); \
+			} \
+			CatchType(_ancestor) { XCEPBENCH_g_Sink++; } \
+			EndTry; \
+		} \
+	}
+
+XCEPBENCH_DEFINE_CATCH_TYPE(0, BenchLevel7)
+XCEPBENCH_DEFINE_CATCH_TYPE(1, BenchLevel6)
+XCEPBENCH_DEFINE_CATCH_TYPE(3, BenchLevel4)
+XCEPBENCH_DEFINE_CATCH_TYPE(6, BenchLevel1)
+XCEPBENCH_DEFINE_CATCH_TYPE(7, Exception)
+
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API
+
+// =========================================================
+// MARK: ParallelFor, batch of 4096 indices on `param` workers, complete or cancelled by its first index
+// =========================================================
+
+#define XCEPBENCH_TASK_BATCH 4096
+
+static XCEP_t_TaskGroup XCEPBENCH_g_TaskGroup;
+static int XCEPBENCH_g_TaskWorkers = 0;
+
+// The group is kept between calibration runs, worker threads are only started when `param` changes
+static XCEP_t_TaskGroup* bench_task_group(const int inWorkers) {
+	if (XCEPBENCH_g_TaskWorkers != inWorkers) {
+		if (XCEPBENCH_g_TaskWorkers) XCEP_TaskGroupDestroy(&XCEPBENCH_g_TaskGroup);
+		XCEPBENCH_g_TaskWorkers = XCEP_TaskGroupInit(&XCEPBENCH_g_TaskGroup, inWorkers, XCEP_TASK_RETHROW_FIRST) == 0 ? inWorkers : 0;
+	}
+	return XCEPBENCH_g_TaskWorkers ? &XCEPBENCH_g_TaskGroup : NULL;
+}
+
+static void bench_task_body(const long inIndex, void* inArg) {
+	XCEP_CheckCancel();
+	if (inIndex == *(const long*)inArg) Throw(XCEPBENCH_ERR_BENCH, "bench");
+	long vValue = inIndex;
+	for (int i = 0; i < 64; ++i) vValue = vValue * 31 + i;
+	XCEPBENCH_g_Sink += vValue & 1;
+}
+
+static void bench_parallel_for(const long inIterations, const long inFailAt, const int inWorkers) {
+	XCEP_t_TaskGroup* vGroup = bench_task_group(inWorkers);
+	if (vGroup == NULL) return;
+	long vFailAt = inFailAt;
+	for (long i = 0; i < inIterations; ++i) {
+		Try {
+			XCEP_ParallelFor(vGroup, 0, XCEPBENCH_TASK_BATCH, 16, bench_task_body, &vFailAt);
+		}
+		CatchAll { XCEPBENCH_g_Sink++; }
+		EndTry;
+	}
+}
+
+static void bench_parallel_for_complete(const long inIterations, const int inParam) {
+	bench_parallel_for(inIterations, -1, inParam);
+}
+
+static void bench_parallel_for_cancelled(const long inIterations, const int inParam) {
+	bench_parallel_for(inIterations, 0, inParam);
+}
+
+#endif
+
+// =========================================================
+// MARK: Batches of 64 items failing 1 in `param`, one Throw per error vs results escalated once per batch
+// =========================================================
+
+#define XCEPBENCH_BATCH 64
+
+static XCEPBENCH_NOINLINE void batch_item_throw(const long inItem, const int inPeriod) {
+	if (inItem % inPeriod == inPeriod - 1) Throw(XCEPBENCH_ERR_BENCH, "bad item");
+	XCEPBENCH_g_Sink++;
+}
+
+static XCEPBENCH_NOINLINE XCEP_t_Result batch_item_result(const long inItem, const int inPeriod) {
+	if (inItem % inPeriod == inPeriod - 1) return Fail(XCEPBENCH_ERR_BENCH, "bad item");
+	XCEPBENCH_g_Sink++;
+	return Ok();
+}
+
+// Every failing item is caught by its own Try
+static void bench_batch_throw_per_error(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		for (volatile long j = 0; j < XCEPBENCH_BATCH; ++j) {
+			Try {
+				batch_item_throw(i * XCEPBENCH_BATCH + j, inParam);
+			}
+			Catch(XCEPBENCH_ERR_BENCH) { XCEPBENCH_g_Sink--; }
+			EndTry;
+		}
+	}
+}
+
+// Every failing item is handled where it is returned, nothing is thrown
+static void bench_batch_result_per_error(const long inIterations, const int inParam) {
+	for (long i = 0; i < inIterations; ++i) {
+		for (long j = 0; j < XCEPBENCH_BATCH; ++j) {
+			if (batch_item_result(i * XCEPBENCH_BATCH + j, inParam).code != 0) XCEPBENCH_g_Sink--;
+		}
+	}
+}
+
+// The first failure aborts the batch: thrown from the item
+static void bench_batch_throw_escalate(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			for (long j = 0; j < XCEPBENCH_BATCH; ++j) batch_item_throw(i * XCEPBENCH_BATCH + j, inParam);
+		}
+		Catch(XCEPBENCH_ERR_BENCH) { XCEPBENCH_g_Sink--; }
+		EndTry;
+	}
+}
+
+static XCEPBENCH_NOINLINE XCEP_t_Result batch_result(const long inBatch, const int inPeriod) {
+	for (long j = 0; j < XCEPBENCH_BATCH; ++j) Check(batch_item_result(inBatch * XCEPBENCH_BATCH + j, inPeriod));
+	return Ok();
+}
+
+// Same, returned up to the batch boundary and thrown there
+static void bench_batch_result_escalate(const long inIterations, const int inParam) {
+	for (volatile long i = 0; i < inIterations; ++i) {
+		Try {
+			TryResult(batch_result(i, inParam));
+		}
+		Catch(XCEPBENCH_ERR_BENCH) { XCEPBENCH_g_Sink--; }
+		EndTry;
+	}
+}
+
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH
+
+// =========================================================
+// MARK: Context switch, the fiber context bound and unbound around each Try as a scheduler would
+// =========================================================
+
+static void bench_context_switch_try(const long inIterations, const int inParam) {
+	(void)inParam;
+	static XCEP_t_Context sFiber;
+	XCEP_ContextInit(&sFiber);
+	for (volatile long i = 0; i < inIterations; ++i) {
+		XCEP_ContextSwitch(NULL, &sFiber);
+		Try {
+			XCEPBENCH_g_Sink++;
+		}
+		EndTry;
+		XCEP_ContextSwitch(&sFiber, NULL);
+	}
+}
+
+#endif
+
+// =========================================================
+// MARK: Random nested programs of the test harness, the same ones in every configuration
+// =========================================================
+
+#define XCEPBENCH_RANDOM_PROGRAMS 256
+
+static XCEPTEST_t_RandomProgram* XCEPBENCH_g_RandomPrograms = NULL;
+static int XCEPBENCH_g_RandomDepth = -1;
+
+// One program per iteration, inParam is the maximum Try nesting
+static void bench_random_programs(const long inIterations, const int inParam) {
+	if (XCEPBENCH_g_RandomPrograms == NULL) {
+		XCEPBENCH_g_RandomPrograms = malloc(sizeof(XCEPTEST_t_RandomProgram) * XCEPBENCH_RANDOM_PROGRAMS);
+		if (XCEPBENCH_g_RandomPrograms == NULL) {
+			fprintf(stderr, "Failed to allocate the random programs\n");
+			exit(1);
+		}
+	}
+	if (XCEPBENCH_g_RandomDepth != inParam) {
+		for (int i = 0; i < XCEPBENCH_RANDOM_PROGRAMS; ++i) {
+			XCEPTEST_RandomGenerate(&XCEPBENCH_g_RandomPrograms[i], (unsigned long long)i + 1, inParam);
+		}
+		XCEPBENCH_g_RandomDepth = inParam;
+	}
+	for (long i = 0; i < inIterations; ++i) {
+		XCEPTEST_t_RandomProgram* vProgram = &XCEPBENCH_g_RandomPrograms[i & (XCEPBENCH_RANDOM_PROGRAMS - 1)];
+		XCEPTEST_RandomExecute(vProgram);
+		XCEPBENCH_g_Sink += vProgram->trace_size;
+	}
+}
+
+// =========================================================
+// MARK: Throughput on 1..N threads
+// =========================================================
+
+static void bench_throughput_errcode(const long inIterations, const int inParam) {
+	(void)inParam;
+	bench_errcode_call_depth(inIterations, 1);
+}
+
+unsigned XCEPBENCH_FrameSize(void) {
+	return (unsigned)sizeof(XCEP_t_Frame);
+}
+
+// =========================================================
+// MARK: Suite
+// =========================================================
+
+void XCEPBENCH_SuiteCore(void) {
+	static const int kDepths[] = { 1, 2, 4, 8, 16, 32, 64 };
+	static const int kDepthCount = (int)(sizeof(kDepths) / sizeof(kDepths[0]));
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+	// Throws are logged, measure them with the drainer running and writing to the null device
+#if defined(_WIN32)
+	FILE* vLogOutput = fopen("NUL", "w");
+#else
+	FILE* vLogOutput = fopen("/dev/null", "w");
+#endif
+	XCEP_LogStart(vLogOutput);
+#endif
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+	// Every throw and catch is recorded, the file is removed at the end
+	if (XCEP_RecorderOpen("XCEPBENCH_recorder.bin") != 0) {
+		fprintf(stderr, "# cannot open the flight recorder file\n");
+	}
+#endif
+
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "try_no_throw", 0, bench_try_no_throw);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "try_finally_no_throw", 0, bench_try_finally_no_throw);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "errcode_no_error", 0, bench_errcode_no_error);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "try_ctx_no_throw", 0, bench_try_ctx_no_throw);
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "context_switch_try", 0, bench_context_switch_try);
+#endif
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_catch", 0, bench_throw_catch);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_catch_ctx", 0, bench_throw_catch_ctx);
+#if XCEP_CONF_PAYLOAD_SIZE
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_catch_payload", 0, bench_throw_catch_payload);
+#endif
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_catch_formatted", 0, bench_throw_catch_formatted);
+#endif
+
+	for (int i = 0; i < kDepthCount; ++i) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_call_depth", kDepths[i], bench_throw_call_depth);
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "errcode_call_depth", kDepths[i], bench_errcode_call_depth);
+	}
+	for (int i = 0; i < kDepthCount; ++i) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_try_depth", kDepths[i], bench_throw_try_depth);
+	}
+#if XCEP_CONF_ENABLE_DEFER
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "defer_release", 0, bench_defer_release);
+	for (int i = 0; i < kDepthCount; ++i) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_defer_depth", kDepths[i], bench_throw_defer_depth);
+	}
+#endif
+	for (int i = 0; i < kDepthCount; ++i) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "rethrow_depth", kDepths[i], bench_rethrow_depth);
+#if XCEP_CONF_CAUSE_DEPTH
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "wrap_cause_depth", kDepths[i], bench_wrap_cause_depth);
+#endif
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_catch_other_depth", kDepths[i], bench_throw_catch_other_depth);
+#if XCEP_CONF_ENABLE_TWO_PHASE
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "throw_filter_depth", kDepths[i], bench_throw_filter_depth);
+#endif
+	}
+
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 1, bench_catch_chain_1);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 2, bench_catch_chain_2);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 4, bench_catch_chain_4);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 8, bench_catch_chain_8);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 16, bench_catch_chain_16);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 32, bench_catch_chain_32);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_chain", 64, bench_catch_chain_64);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_any", 4, bench_catch_any_4);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_any", 16, bench_catch_any_16);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_any", 64, bench_catch_any_64);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_in", 4, bench_catch_in_4);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_in", 16, bench_catch_in_16);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_in", 64, bench_catch_in_64);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_range", 64, bench_catch_range);
+	for (int vLength = 1; vLength <= 64; vLength *= 2) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "errcode_dispatch", vLength, bench_errcode_dispatch);
+	}
+	for (int vPeriod = 1; vPeriod <= 4096; vPeriod *= 8) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "batch_throw_per_error", vPeriod, bench_batch_throw_per_error);
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "batch_result_per_error", vPeriod, bench_batch_result_per_error);
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "batch_throw_escalate", vPeriod, bench_batch_throw_escalate);
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "batch_result_escalate", vPeriod, bench_batch_result_escalate);
+	}
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "random_programs", 2, bench_random_programs);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "random_programs", 4, bench_random_programs);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "random_programs", 6, bench_random_programs);
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_type", 0, bench_catch_type_0);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_type", 1, bench_catch_type_1);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_type", 3, bench_catch_type_3);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_type", 6, bench_catch_type_6);
+	XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "catch_type", 7, bench_catch_type_7);
+#endif
+
+	for (int vThreads = 1; vThreads <= XCEPBENCH_g_Options->max_threads; vThreads *= 2) {
+		XCEPBENCH_RunThreaded(XCEPBENCH_SUITE_CORE, "mt_throw_catch", 0, vThreads, bench_throw_catch);
+		XCEPBENCH_RunThreaded(XCEPBENCH_SUITE_CORE, "mt_errcode", 0, vThreads, bench_throughput_errcode);
+		if (vThreads < XCEPBENCH_g_Options->max_threads && vThreads * 2 > XCEPBENCH_g_Options->max_threads) {
+			vThreads = XCEPBENCH_g_Options->max_threads / 2;
+		}
+	}
+
+#if XCEP_CONF_ENABLE_THREAD_API
+	for (int vWorkers = 1; vWorkers <= XCEP_CONF_TASK_MAX_WORKERS && vWorkers <= XCEPBENCH_g_Options->max_threads; vWorkers *= 2) {
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "parallel_for_complete", vWorkers, bench_parallel_for_complete);
+		XCEPBENCH_Run(XCEPBENCH_SUITE_CORE, "parallel_for_cancelled", vWorkers, bench_parallel_for_cancelled);
+	}
+	if (XCEPBENCH_g_TaskWorkers) XCEP_TaskGroupDestroy(&XCEPBENCH_g_TaskGroup);
+#endif
+
+	free(XCEPBENCH_g_RandomPrograms);
+	XCEPBENCH_g_RandomPrograms = NULL;
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+	XCEP_LogStop();
+	if (vLogOutput) fclose(vLogOutput);
+	fprintf(stderr, "# %lld log records dropped\n", XCEP_LogDropped());
+#endif
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+	XCEP_RecorderClose();
+	remove("XCEPBENCH_recorder.bin");
+#endif
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XCEPBENCH_bench.h"
+
+static void usage(const char* inProgram) {
+	printf("Usage: %s [options]\n", inProgram);
+	printf("  --format=table|csv|json   Output format (default: table)\n");
+	printf("  --filter=TEXT             Only run benchmarks whose suite/name contains TEXT\n");
+	printf("  --threads=N               Max threads for the throughput mode (default: cpu count)\n");
+	printf("  --min-time=MS             Minimum duration of a single-threaded measurement (default: 100)\n");
+	printf("  --thread-iterations=N     Iterations per thread in throughput mode (default: 200000)\n");
+}
+
+static int parse_format(const char* inValue, XCEPBENCH_t_Format* outFormat) {
+	if (strcmp(inValue, "table") == 0) *outFormat = XCEPBENCH_FORMAT_TABLE;
+	else if (strcmp(inValue, "csv") == 0) *outFormat = XCEPBENCH_FORMAT_CSV;
+	else if (strcmp(inValue, "json") == 0) *outFormat = XCEPBENCH_FORMAT_JSON;
+	else return 0;
+	return 1;
+}
+
+int main(const int argc, char** argv) {
+	XCEPBENCH_t_Options vOptions = {
+		.format = XCEPBENCH_FORMAT_TABLE,
+		.filter = NULL,
+		.max_threads = XCEPBENCH_CpuCount(),
+		.min_time_ms = 100,
+		.thread_iterations = 200000,
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		const char* vArg = argv[i];
+		if (strncmp(vArg, "--format=", 9) == 0) {
+			if (!parse_format(vArg + 9, &vOptions.format)) {
+				fprintf(stderr, "Unknown format: %s\n", vArg + 9);
+				return 2;
+			}
+		} else if (strncmp(vArg, "--filter=", 9) == 0) {
+			vOptions.filter = vArg + 9;
+		} else if (strncmp(vArg, "--threads=", 10) == 0) {
+			vOptions.max_threads = atoi(vArg + 10);
+		} else if (strncmp(vArg, "--min-time=", 11) == 0) {
+			vOptions.min_time_ms = atoi(vArg + 11);
+		} else if (strncmp(vArg, "--thread-iterations=", 20) == 0) {
+			vOptions.thread_iterations = atol(vArg + 20);
+		} else {
+			usage(argv[0]);
+			return strcmp(vArg, "--help") == 0 ? 0 : 2;
+		}
+	}
+
+	if (vOptions.max_threads < 1) vOptions.max_threads = 1;
+	if (vOptions.min_time_ms < 1) vOptions.min_time_ms = 1;
+	if (vOptions.thread_iterations < 1) vOptions.thread_iterations = 1;
+
+	XCEPBENCH_g_Options = &vOptions;
+
+	XCEPBENCH_ReportBegin();
+	XCEPBENCH_SuiteCore();
+	XCEPBENCH_ReportEnd();
+
+	return 0;
+}
@@ -0,0 +1,437 @@
+#include "XCEPTEST_random.h"
+
+#include <XCEP.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    XCEPTEST_RANDOM_OP_MARK,
+    XCEPTEST_RANDOM_OP_THROW,
+    XCEPTEST_RANDOM_OP_RETHROW, // Only generated at the top of a handler block, Rethrow needs the Catch in scope
+    XCEPTEST_RANDOM_OP_TRY
+};
+
+enum {
+    XCEPTEST_RANDOM_SHAPE_CATCH,        // Catch, Catch, CatchRange, Finally
+    XCEPTEST_RANDOM_SHAPE_CATCH_ALL,    // Catch, CatchAll, Finally
+    XCEPTEST_RANDOM_SHAPE_FINALLY_ONLY, // Finally
+    XCEPTEST_RANDOM_SHAPE_COUNT
+};
+
+enum {
+    XCEPTEST_RANDOM_BLOCK_BODY,
+    XCEPTEST_RANDOM_BLOCK_HANDLER,
+    XCEPTEST_RANDOM_BLOCK_FINALLY // Marks only: a throw in Finally would enter the Catch blocks of its own Try
+};
+
+// Trace events, (kind << 16) | value
+enum {
+    XCEPTEST_RANDOM_EV_MARK = 1,
+    XCEPTEST_RANDOM_EV_THROW,
+    XCEPTEST_RANDOM_EV_TRY,
+    XCEPTEST_RANDOM_EV_CATCH,   // node * 4 + clause
+    XCEPTEST_RANDOM_EV_CODE,    // CaughtException.code seen by the clause
+    XCEPTEST_RANDOM_EV_RETHROW,
+    XCEPTEST_RANDOM_EV_FINALLY,
+    XCEPTEST_RANDOM_EV_END,     // Left the Try without propagating
+    XCEPTEST_RANDOM_EV_ESCAPE   // Reached the outermost CatchAll
+};
+
+#define XCEPTEST_RANDOM_CODES 4
+
+static const char* const XCEPTEST_g_random_events[] = {
+    "?", "mark", "throw", "try", "catch", "code", "rethrow", "finally", "end", "escape"
+};
+
+static void random_push(XCEPTEST_t_RandomProgram* program, const int kind, const int value) {
+    if (program->trace_size < XCEPTEST_RANDOM_MAX_TRACE) {
+        program->trace[program->trace_size++] = (kind << 16) | value;
+    }
+}
+
+// =========================================================
+// MARK: Generator
+// =========================================================
+
+static unsigned random_next(XCEPTEST_t_RandomProgram* program, const unsigned bound) {
+    // xorshift64*
+    unsigned long long x = program->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    program->rng = x;
+    return (unsigned)((x * 0x2545F4914F6CDD1Dull) >> 33) % bound;
+}
+
+static int random_new_node(XCEPTEST_t_RandomProgram* program, const int op) {
+    if (program->node_count >= XCEPTEST_RANDOM_MAX_NODES) return -1;
+    const int index = program->node_count++;
+    XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    memset(node, 0, sizeof(*node));
+    node->op = op;
+    node->body = node->handlers[0] = node->handlers[1] = node->handlers[2] = node->finally_block = node->next = -1;
+    return index;
+}
+
+static int random_block(XCEPTEST_t_RandomProgram* program, int depth, int kind);
+
+static int random_try(XCEPTEST_t_RandomProgram* program, const int depth) {
+    const int index = random_new_node(program, XCEPTEST_RANDOM_OP_TRY);
+    if (index < 0) return -1;
+
+    XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    node->shape = (int)random_next(program, XCEPTEST_RANDOM_SHAPE_COUNT);
+    for (int i = 0; i < 2; ++i) {
+        // One chance in five for a clause that never matches
+        node->codes[i] = (int)random_next(program, XCEPTEST_RANDOM_CODES + 1);
+    }
+    node->range_low = 1 + (int)random_next(program, XCEPTEST_RANDOM_CODES);
+    node->range_high = node->range_low - 1 + (int)random_next(program, 3);
+
+    // Children are allocated after the node, re-read it through the index
+    const int body = random_block(program, depth - 1, XCEPTEST_RANDOM_BLOCK_BODY);
+    program->nodes[index].body = body;
+    if (program->nodes[index].shape != XCEPTEST_RANDOM_SHAPE_FINALLY_ONLY) {
+        for (int i = 0; i < 3; ++i) {
+            const int handler = random_block(program, depth - 1, XCEPTEST_RANDOM_BLOCK_HANDLER);
+            program->nodes[index].handlers[i] = handler;
+        }
+    }
+    const int finally_block = random_block(program, depth - 1, XCEPTEST_RANDOM_BLOCK_FINALLY);
+    program->nodes[index].finally_block = finally_block;
+    return index;
+}
+
+static int random_block(XCEPTEST_t_RandomProgram* program, const int depth, const int kind) {
+    int head = -1;
+    int tail = -1;
+    const unsigned count = random_next(program, 5);
+    for (unsigned i = 0; i < count; ++i) {
+        const unsigned pick = random_next(program, 10);
+        int index;
+        if (kind == XCEPTEST_RANDOM_BLOCK_FINALLY || pick < 4) {
+            index = random_new_node(program, XCEPTEST_RANDOM_OP_MARK);
+            if (index >= 0) program->nodes[index].value = index;
+        } else if (pick < 6 || (pick == 9 && kind != XCEPTEST_RANDOM_BLOCK_HANDLER) || (pick < 9 && depth <= 0)) {
+            index = random_new_node(program, XCEPTEST_RANDOM_OP_THROW);
+            if (index >= 0) program->nodes[index].value = 1 + (int)random_next(program, XCEPTEST_RANDOM_CODES);
+        } else if (pick == 9) {
+            index = random_new_node(program, XCEPTEST_RANDOM_OP_RETHROW);
+        } else {
+            index = random_try(program, depth);
+        }
+        if (index < 0) break;
+
+        if (tail < 0) head = index;
+        else program->nodes[tail].next = index;
+        tail = index;
+    }
+    return head;
+}
+
+void XCEPTEST_RandomGenerate(XCEPTEST_t_RandomProgram* outProgram, const unsigned long long inSeed, const int inMaxDepth) {
+    outProgram->node_count = 0;
+    outProgram->trace_size = 0;
+    outProgram->last_code = 0;
+    outProgram->throws = 0;
+    // splitmix64 of the seed, xorshift needs a non-zero state
+    unsigned long long z = inSeed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    outProgram->rng = (z ^ (z >> 31)) | 1;
+    outProgram->root = random_block(outProgram, inMaxDepth, XCEPTEST_RANDOM_BLOCK_BODY);
+}
+
+// =========================================================
+// MARK: Execution under XCEP
+// =========================================================
+
+static void random_execute_block(XCEPTEST_t_RandomProgram* program, int head);
+
+// Expanded inside the clause so that Rethrow sees its Try
+#define XCEPTEST_RANDOM_HANDLER(_clause) \
+    random_push(program, XCEPTEST_RANDOM_EV_CATCH, index * 4 + (_clause)); \
+    random_push(program, XCEPTEST_RANDOM_EV_CODE, CaughtException.code); \
+    for (int h = node->handlers[_clause]; h >= 0; h = program->nodes[h].next) { \
+        if (program->nodes[h].op == XCEPTEST_RANDOM_OP_RETHROW) { \
+            random_push(program, XCEPTEST_RANDOM_EV_RETHROW, 0); \
+            Rethrow; \
+        } else { \
+            random_execute_node(program, h); \
+        } \
+    }
+
+#define XCEPTEST_RANDOM_FINALLY \
+    Finally { \
+        random_push(program, XCEPTEST_RANDOM_EV_FINALLY, index); \
+        random_execute_block(program, node->finally_block); \
+    }
+
+static void random_execute_node(XCEPTEST_t_RandomProgram* program, int index);
+
+static void random_execute_try(XCEPTEST_t_RandomProgram* program, const int index) {
+    const XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    switch (node->shape) {
+        case XCEPTEST_RANDOM_SHAPE_CATCH:
+            Try {
+                random_push(program, XCEPTEST_RANDOM_EV_TRY, index);
+                random_execute_block(program, node->body);
+            }
+            Catch(node->codes[0]) { XCEPTEST_RANDOM_HANDLER(0) }
+            Catch(node->codes[1]) { XCEPTEST_RANDOM_HANDLER(1) }
+            CatchRange(node->range_low, node->range_high) { XCEPTEST_RANDOM_HANDLER(2) }
+            XCEPTEST_RANDOM_FINALLY
+            EndTry;
+            break;
+        case XCEPTEST_RANDOM_SHAPE_CATCH_ALL:
+            Try {
+                random_push(program, XCEPTEST_RANDOM_EV_TRY, index);
+                random_execute_block(program, node->body);
+            }
+            Catch(node->codes[0]) { XCEPTEST_RANDOM_HANDLER(0) }
+            CatchAll { XCEPTEST_RANDOM_HANDLER(2) }
+            XCEPTEST_RANDOM_FINALLY
+            EndTry;
+            break;
+        default:
+            Try {
+                random_push(program, XCEPTEST_RANDOM_EV_TRY, index);
+                random_execute_block(program, node->body);
+            }
+            XCEPTEST_RANDOM_FINALLY
+            EndTry;
+            break;
+    }
+    random_push(program, XCEPTEST_RANDOM_EV_END, index);
+}
+
+static void random_execute_node(XCEPTEST_t_RandomProgram* program, const int index) {
+    const XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    switch (node->op) {
+        case XCEPTEST_RANDOM_OP_MARK:
+            random_push(program, XCEPTEST_RANDOM_EV_MARK, node->value);
+            break;
+        case XCEPTEST_RANDOM_OP_THROW:
+            random_push(program, XCEPTEST_RANDOM_EV_THROW, node->value);
+            program->throws++;
+            Throw(node->value, "random program");
+            break;
+        case XCEPTEST_RANDOM_OP_TRY:
+            random_execute_try(program, index);
+            break;
+        default:
+            break;
+    }
+}
+
+static void random_execute_block(XCEPTEST_t_RandomProgram* program, int head) {
+    for (; head >= 0; head = program->nodes[head].next) {
+        random_execute_node(program, head);
+    }
+}
+
+void XCEPTEST_RandomExecute(XCEPTEST_t_RandomProgram* inProgram) {
+    inProgram->trace_size = 0;
+    inProgram->throws = 0;
+    Try {
+        random_execute_block(inProgram, inProgram->root);
+    }
+    CatchAll {
+        random_push(inProgram, XCEPTEST_RANDOM_EV_ESCAPE, CaughtException.code);
+    }
+    EndTry;
+}
+
+// =========================================================
+// MARK: Reference Interpreter
+// =========================================================
+
+// Every function returns the code propagating out of it, 0 when none
+
+static int random_reference_block(XCEPTEST_t_RandomProgram* program, int head);
+static int random_reference_node(XCEPTEST_t_RandomProgram* program, int index);
+
+static int random_reference_match(const XCEPTEST_t_RandomNode* node, const int code) {
+    switch (node->shape) {
+        case XCEPTEST_RANDOM_SHAPE_CATCH:
+            if (code == node->codes[0]) return 0;
+            if (code == node->codes[1]) return 1;
+            if (code >= node->range_low && code <= node->range_high) return 2;
+            return -1;
+        case XCEPTEST_RANDOM_SHAPE_CATCH_ALL:
+            return code == node->codes[0] ? 0 : 2;
+        default:
+            return -1;
+    }
+}
+
+static int random_reference_try(XCEPTEST_t_RandomProgram* program, const int index) {
+    const XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    random_push(program, XCEPTEST_RANDOM_EV_TRY, index);
+
+    int propagate = 0;
+    int rethrown = 0;
+    if (random_reference_block(program, node->body) != 0) {
+        const int clause = random_reference_match(node, program->last_code);
+        if (clause >= 0) {
+            random_push(program, XCEPTEST_RANDOM_EV_CATCH, index * 4 + clause);
+            random_push(program, XCEPTEST_RANDOM_EV_CODE, program->last_code);
+            rethrown = program->last_code;
+            // The rest of the handler runs after a Rethrow, a later throw replaces the rethrown exception
+            for (int h = node->handlers[clause]; h >= 0; h = program->nodes[h].next) {
+                if (program->nodes[h].op == XCEPTEST_RANDOM_OP_RETHROW) {
+                    random_push(program, XCEPTEST_RANDOM_EV_RETHROW, 0);
+                    propagate = 1;
+                } else if (random_reference_node(program, h) != 0) {
+                    propagate = 1;
+                    rethrown = 0;
+                    break;
+                }
+            }
+        } else {
+            propagate = 1;
+        }
+    }
+
+    random_push(program, XCEPTEST_RANDOM_EV_FINALLY, index);
+    random_reference_block(program, node->finally_block);
+
+    // Rethrow propagates the exception the handler took, not the ones caught by a Try nested in it since
+    if (propagate && rethrown != 0) program->last_code = rethrown;
+    if (propagate) return program->last_code;
+    random_push(program, XCEPTEST_RANDOM_EV_END, index);
+    return 0;
+}
+
+// One statement of a block
+static int random_reference_node(XCEPTEST_t_RandomProgram* program, const int index) {
+    const XCEPTEST_t_RandomNode* node = &program->nodes[index];
+    switch (node->op) {
+        case XCEPTEST_RANDOM_OP_MARK:
+            random_push(program, XCEPTEST_RANDOM_EV_MARK, node->value);
+            return 0;
+        case XCEPTEST_RANDOM_OP_THROW:
+            random_push(program, XCEPTEST_RANDOM_EV_THROW, node->value);
+            program->last_code = node->value;
+            return node->value;
+        case XCEPTEST_RANDOM_OP_TRY:
+            return random_reference_try(program, index);
+        default:
+            return 0;
+    }
+}
+
+static int random_reference_block(XCEPTEST_t_RandomProgram* program, int head) {
+    for (; head >= 0; head = program->nodes[head].next) {
+        const int code = random_reference_node(program, head);
+        if (code != 0) return code;
+    }
+    return 0;
+}
+
+static void random_reference(XCEPTEST_t_RandomProgram* program) {
+    if (random_reference_block(program, program->root) != 0) {
+        random_push(program, XCEPTEST_RANDOM_EV_ESCAPE, program->last_code);
+    }
+}
+
+// =========================================================
+// MARK: Runner
+// =========================================================
+
+static void random_print_block(const XCEPTEST_t_RandomProgram* program, int head, const int indent) {
+    for (; head >= 0; head = program->nodes[head].next) {
+        const XCEPTEST_t_RandomNode* node = &program->nodes[head];
+        printf("%*s", indent, "");
+        switch (node->op) {
+            case XCEPTEST_RANDOM_OP_MARK:
+                printf("mark %d;\n", node->value);
+                break;
+            case XCEPTEST_RANDOM_OP_THROW:
+                printf("Throw(%d);\n", node->value);
+                break;
+            case XCEPTEST_RANDOM_OP_RETHROW:
+                printf("Rethrow;\n");
+                break;
+            default:
+                printf("Try { // #%d\n", head);
+                random_print_block(program, node->body, indent + 4);
+                if (node->shape == XCEPTEST_RANDOM_SHAPE_CATCH) {
+                    printf("%*s} Catch(%d) {\n", indent, "", node->codes[0]);
+                    random_print_block(program, node->handlers[0], indent + 4);
+                    printf("%*s} Catch(%d) {\n", indent, "", node->codes[1]);
+                    random_print_block(program, node->handlers[1], indent + 4);
+                    printf("%*s} CatchRange(%d, %d) {\n", indent, "", node->range_low, node->range_high);
+                    random_print_block(program, node->handlers[2], indent + 4);
+                } else if (node->shape == XCEPTEST_RANDOM_SHAPE_CATCH_ALL) {
+                    printf("%*s} Catch(%d) {\n", indent, "", node->codes[0]);
+                    random_print_block(program, node->handlers[0], indent + 4);
+                    printf("%*s} CatchAll {\n", indent, "");
+                    random_print_block(program, node->handlers[2], indent + 4);
+                }
+                printf("%*s} Finally {\n", indent, "");
+                random_print_block(program, node->finally_block, indent + 4);
+                printf("%*s} EndTry;\n", indent, "");
+                break;
+        }
+    }
+}
+
+void XCEPTEST_RandomPrint(const XCEPTEST_t_RandomProgram* inProgram) {
+    random_print_block(inProgram, inProgram->root, 4);
+}
+
+static void random_print_event(const char* label, const XCEPTEST_t_RandomProgram* program, const int position) {
+    if (position >= program->trace_size) {
+        printf("   %s: <end of trace>\n", label);
+        return;
+    }
+    const int event = program->trace[position];
+    printf("   %s: %s %d\n", label, XCEPTEST_g_random_events[event >> 16], event & 0xFFFF);
+}
+
+int XCEPTEST_RandomRun(const unsigned long long inSeed, const long inCount, const int inMaxDepth, XCEPTEST_t_RandomStats* outStats) {
+    XCEPTEST_t_RandomProgram* actual = malloc(sizeof(XCEPTEST_t_RandomProgram));
+    XCEPTEST_t_RandomProgram* expected = malloc(sizeof(XCEPTEST_t_RandomProgram));
+    if (actual == NULL || expected == NULL) {
+        free(actual);
+        free(expected);
+        return 0;
+    }
+
+    long mismatches = 0;
+    for (long i = 0; i < inCount; ++i) {
+        const unsigned long long seed = inSeed + (unsigned long long)i;
+        XCEPTEST_RandomGenerate(actual, seed, inMaxDepth);
+        memcpy(expected, actual, sizeof(XCEPTEST_t_RandomProgram));
+
+        XCEPTEST_RandomExecute(actual);
+        random_reference(expected);
+
+        outStats->programs++;
+        outStats->events += actual->trace_size;
+        outStats->throws += actual->throws;
+
+        int position = 0;
+        while (position < actual->trace_size && position < expected->trace_size
+            && actual->trace[position] == expected->trace[position]) {
+            position++;
+        }
+        if (position == actual->trace_size && position == expected->trace_size) continue;
+
+        if (mismatches++ == 0 && outStats->mismatches == 0) {
+            outStats->first_failed_seed = seed;
+            printf("   Trace mismatch for seed %llu at event %d\n", seed, position);
+            random_print_event("XCEP     ", actual, position);
+            random_print_event("reference", expected, position);
+            XCEPTEST_RandomPrint(actual);
+        }
+    }
+    outStats->mismatches += mismatches;
+
+    free(actual);
+    free(expected);
+    return mismatches == 0;
+}
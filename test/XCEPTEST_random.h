@@ -0,0 +1,54 @@
+#ifndef XCEPTEST_RANDOM_H
+#define XCEPTEST_RANDOM_H
+
+// Random nested programs of Throw, Catch, CatchAll, CatchRange, Rethrow, throws inside a Catch and Finally-only
+// frames. Every program runs once under XCEP and once in a reference interpreter, both record a trace of the
+// control flow and the traces must be equal.
+
+#define XCEPTEST_RANDOM_MAX_NODES 128
+#define XCEPTEST_RANDOM_MAX_TRACE 1024
+
+typedef struct {
+    int op;           // XCEPTEST_RANDOM_OP_*
+    int value;        // Mark id or thrown code
+    int shape;        // Try only, XCEPTEST_RANDOM_SHAPE_*
+    int codes[2];     // Catch(codes[i]), 0 is never thrown
+    int range_low;    // CatchRange(range_low, range_high), empty when low > high
+    int range_high;
+    int body;         // First node of each block, -1 when empty
+    int handlers[3];
+    int finally_block;
+    int next;         // Next node of the same block
+} XCEPTEST_t_RandomNode;
+
+typedef struct {
+    XCEPTEST_t_RandomNode nodes[XCEPTEST_RANDOM_MAX_NODES];
+    int node_count;
+    int root;
+    unsigned long long rng;
+    int trace[XCEPTEST_RANDOM_MAX_TRACE];
+    int trace_size;
+    int last_code;    // Reference only: the exception Rethrow and EndTry propagate, as the context's last one
+    long throws;
+} XCEPTEST_t_RandomProgram;
+
+typedef struct {
+    long programs;
+    long events;
+    long throws;
+    long mismatches;
+    unsigned long long first_failed_seed;
+} XCEPTEST_t_RandomStats;
+
+// Builds the program of inSeed, at most inMaxDepth nested Try
+void XCEPTEST_RandomGenerate(XCEPTEST_t_RandomProgram* outProgram, unsigned long long inSeed, int inMaxDepth);
+
+// Runs it under XCEP, the trace is left in the program. A program can be executed again.
+void XCEPTEST_RandomExecute(XCEPTEST_t_RandomProgram* inProgram);
+
+// Programs inSeed .. inSeed + inCount - 1, prints the first mismatching program. Returns 1 when every trace matched.
+int XCEPTEST_RandomRun(unsigned long long inSeed, long inCount, int inMaxDepth, XCEPTEST_t_RandomStats* outStats);
+
+void XCEPTEST_RandomPrint(const XCEPTEST_t_RandomProgram* inProgram);
+
+#endif //XCEPTEST_RANDOM_H
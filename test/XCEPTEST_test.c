@@ -31,6 +31,12 @@ int XCEPTEST_g_tests_failed = 0;
 #define XCEPTEST_BOOL2STR_IMPL(x) XCEPTEST_BOOL2STR_##x
 #define XCEPTEST_BOOL2STR(x) XCEPTEST_BOOL2STR_IMPL(x)
 
+#if defined(_MSC_VER)
+    #define XCEPTEST_NOINLINE __declspec(noinline)
+#else
+    #define XCEPTEST_NOINLINE __attribute__((noinline))
+#endif
+
 // =========================================================
 // MARK: Exception Codes
 // =========================================================
@@ -45,6 +51,37 @@ enum XCEPTEST_ExceptionCodes {
     XCEPTEST_ERR_DEEP_RETHROW = 106,
     XCEPTEST_ERR_CLEANUP = 107,
     XCEPTEST_ERR_VOLATILE_TEST = 108,
+    XCEPTEST_ERR_CACHED_CONTEXT = 109,
+    XCEPTEST_ERR_DEFERRED = 110,
+    XCEPTEST_ERR_TYPED_TIMEOUT = 111,
+    XCEPTEST_ERR_FORMATTED = 112,
+    XCEPTEST_ERR_PAYLOAD = 113,
+    XCEPTEST_ERR_BACKTRACE = 114,
+    XCEPTEST_ERR_STATS = 115,
+    XCEPTEST_ERR_LOGGED = 116,
+    XCEPTEST_ERR_CROSS_THREAD = 117,
+    XCEPTEST_ERR_TASK = 118,
+    XCEPTEST_ERR_FIBER = 119,
+    XCEPTEST_ERR_IO_FIRST = 120, // CatchRange tests, 120 to 129 and 130 just outside are not used for anything else
+    XCEPTEST_ERR_IO_LAST = 129,
+    XCEPTEST_ERR_RESULT = 131,
+    XCEPTEST_ERR_COMPACT_SITE = 132,
+    XCEPTEST_ERR_REGISTRY = 133,
+    XCEPTEST_ERR_REGISTRY_OTHER = 134,
+    XCEPTEST_ERR_REGISTRY_THREAD = 135, // + thread index, up to 138
+    XCEPTEST_ERR_TRY_DEPTH = 139,
+    XCEPTEST_ERR_LATENCY = 140,
+    XCEPTEST_ERR_LATENCY_DEEP = 141,
+    XCEPTEST_ERR_LATENCY_RETHROW = 142,
+    XCEPTEST_ERR_LATENCY_THREAD = 143,
+    XCEPTEST_ERR_FILTERED = 144,
+    XCEPTEST_ERR_FILTER_OTHER = 145,
+    XCEPTEST_ERR_FILTER_WHEN = 146,
+    XCEPTEST_ERR_CAUSE_ROOT = 147,
+    XCEPTEST_ERR_CAUSE_PLAIN = 148,
+    XCEPTEST_ERR_CAUSE_LEVEL_BASE = 150, // + level, up to 159
+    XCEPTEST_ERR_RECORDER = 160,
+    XCEPTEST_ERR_RECORDER_THREAD = 161,
     XCEPTEST_ERR_THREAD_BASE = 300
 };
 
@@ -524,39 +561,2311 @@ int test_thread_safety_scalable() {
 }
 
 
-int XCEPTEST_RunTest() {
+// =======================================================
+// MARK: Test case 15: Cached context with TryCtx/ThrowCtx
+// =======================================================
 
-    printf("===== XCEP Test Suite =====\n\n");
+int test_cached_context() {
+    volatile int status = 0;
+    XCEP_t_Context* ctx = XCEP_GetContext();
+
+    for (volatile int i = 0; i < 3; ++i) {
+        TryCtx(ctx) {
+            Try {
+                ThrowCtx(ctx, XCEPTEST_ERR_CACHED_CONTEXT, "thrown through a cached context");
+            }
+            Finally {
+                status++;
+            }
+            EndTry;
+        }
+        Catch(XCEPTEST_ERR_CACHED_CONTEXT) {
+            status++;
+        }
+        EndTry;
+    }
 
-    printf("    XCEP_CONF_ENABLE_THREAD_SAFE=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_THREAD_SAFE) "\n");
-    printf("    XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO) "\n");
-    printf("    XCEP_CONF_ENABLE_CUSTOM_TYPES=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_CUSTOM_TYPES) "\n");
+    printf("   Cached context status %d, stack is %s.\n", status, ctx->stack == NULL ? "empty" : "NOT empty");
+    return status == 6 && ctx->stack == NULL && ctx == XCEP_GetContext();
+}
 
-    puts("");
+// =======================================================
+// MARK: Test case 16: Defer cleanups unwound by a single Try
+// =======================================================
 
-    printf("====== Running Test =======\n\n");
+#if XCEP_CONF_ENABLE_DEFER
 
-    XCEPTEST_RUN_TEST(test_no_throw);
-    XCEPTEST_RUN_TEST(test_simple_catch);
-    XCEPTEST_RUN_TEST(test_catch_all);
-    XCEPTEST_RUN_TEST(test_nested_handled_exception);
-    XCEPTEST_RUN_TEST(test_rethrow);
-    XCEPTEST_RUN_TEST(test_throw_from_catch);
-    XCEPTEST_RUN_TEST(test_nested_uncaught_propagation);
-    XCEPTEST_RUN_TEST(test_nested_rethrow);
-    XCEPTEST_RUN_TEST(test_resource_cleanup_with_finally);
-    XCEPTEST_RUN_TEST(test_volatile_variable_correctness);
-    XCEPTEST_RUN_TEST(test_multiple_catch_blocks);
-    XCEPTEST_RUN_TEST(test_try_finally_only);
-    XCEPTEST_RUN_TEST(test_uncaught_exception);
+#define XCEPTEST_DEFER_DEPTH 8
+
+typedef struct {
+    int released[XCEPTEST_DEFER_DEPTH];
+    int release_order[XCEPTEST_DEFER_DEPTH];
+    int release_count;
+} XCEPTEST_t_DeferLog;
+
+typedef struct {
+    XCEPTEST_t_DeferLog* log;
+    int index;
+} XCEPTEST_t_DeferResource;
+
+void XCEPTEST_release(void* arg) {
+    XCEPTEST_t_DeferResource* resource = arg;
+    resource->log->released[resource->index]++;
+    resource->log->release_order[resource->log->release_count++] = resource->index;
+}
+
+void function_deferring_at_depth(XCEPTEST_t_DeferLog* log, const int depth, const int throw_at_bottom) {
+    XCEPTEST_t_DeferResource resource = { log, depth };
+    Defer(XCEPTEST_release, &resource);
+
+    if (depth + 1 < XCEPTEST_DEFER_DEPTH) {
+        function_deferring_at_depth(log, depth + 1, throw_at_bottom);
+    } else if (throw_at_bottom) {
+        Throw(XCEPTEST_ERR_DEFERRED, "thrown below deferred cleanups");
+    }
+
+    DeferRelease();
+}
+
+int test_defer() {
+    XCEPTEST_t_DeferLog thrown_log = { 0 };
+    XCEPTEST_t_DeferLog normal_log = { 0 };
+    volatile int caught = 0;
+    volatile int cancelled_ran = 0;
+
+    Try {
+        function_deferring_at_depth(&thrown_log, 0, 1);
+    }
+    Catch(XCEPTEST_ERR_DEFERRED) {
+        printf("   Caught after %d deferred cleanups ran.\n", thrown_log.release_count);
+        caught = thrown_log.release_count;
+    }
+    EndTry;
+
+    // Normal path: every function releases its own entry
+    function_deferring_at_depth(&normal_log, 0, 0);
+
+    // Entries left at the end of a Try run with it, cancelled ones never run
+    XCEPTEST_t_DeferLog scope_log = { 0 };
+    XCEPTEST_t_DeferResource scoped = { &scope_log, 0 };
+    XCEPTEST_t_DeferResource cancelled = { &scope_log, 1 };
+    Try {
+        Defer(XCEPTEST_release, &scoped);
+        Defer(XCEPTEST_release, &cancelled);
+        DeferCancel();
+    }
+    EndTry;
+    cancelled_ran = scope_log.released[1];
+
+    int ok = caught == XCEPTEST_DEFER_DEPTH && normal_log.release_count == XCEPTEST_DEFER_DEPTH
+        && scope_log.released[0] == 1 && cancelled_ran == 0 && XCEP_GetContext()->defer_top == 0;
+    for (int i = 0; i < XCEPTEST_DEFER_DEPTH; ++i) {
+        // LIFO: deepest resource first
+        ok = ok && thrown_log.released[i] == 1 && thrown_log.release_order[i] == XCEPTEST_DEFER_DEPTH - 1 - i;
+        ok = ok && normal_log.released[i] == 1 && normal_log.release_order[i] == XCEPTEST_DEFER_DEPTH - 1 - i;
+    }
+    return ok;
+}
+
+void XCEPTEST_count_release(void* arg) {
+    (*(int*)arg)++;
+}
+
+int test_defer_overflow() {
+    static int released = 0;
+    volatile int status = 0;
+    released = 0;
+
+    Try {
+        for (int i = 0; i <= XCEP_CONF_DEFER_STACK_SIZE; ++i) {
+            Defer(XCEPTEST_count_release, &released);
+        }
+        status = -1;
+    }
+    Catch(XCEP_ERR_DEFER_OVERFLOW) {
+        printf("   Overflow caught: %s\n", CaughtException.message);
+        status = 1;
+    }
+    EndTry;
+
+    printf("   %d cleanups ran for %d pushes.\n", released, XCEP_CONF_DEFER_STACK_SIZE + 1);
+    return status == 1 && released == XCEP_CONF_DEFER_STACK_SIZE + 1 && XCEP_GetContext()->defer_top == 0;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 17: Exception type hierarchy
+// =======================================================
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+
+XCEP_DEFINE_TYPE(RuntimeError, Exception);
+XCEP_DEFINE_TYPE(IoError, RuntimeError);
+XCEP_DEFINE_TYPE(FileNotFoundError, IoError);
+XCEP_DEFINE_TYPE_CODE(TimeoutError, IoError, XCEPTEST_ERR_TYPED_TIMEOUT);
+XCEP_DEFINE_TYPE(LogicError, Exception);
+
+// Depth 4 to 8, the last one is one level too deep for the default XCEP_CONF_TYPE_MAX_DEPTH
+XCEP_DEFINE_TYPE(DeepError4, FileNotFoundError);
+XCEP_DEFINE_TYPE(DeepError5, DeepError4);
+XCEP_DEFINE_TYPE(DeepError6, DeepError5);
+XCEP_DEFINE_TYPE(DeepError7, DeepError6);
+XCEP_DEFINE_TYPE(DeepError8, DeepError7);
+
+int test_catch_type() {
+    volatile int caught_io = 0;
+    volatile int caught_sibling = 0;
+    volatile int caught_root = 0;
+    volatile int caught_code = 0;
+    volatile int caught_outer = 0;
+
+    // Subtype caught by an ancestor, clauses are tried in order
+    Try {
+        ThrowType(FileNotFoundError, "config.ini not found");
+    }
+    CatchType(LogicError) {
+        caught_sibling = 1;
+    }
+    CatchType(IoError) {
+        printf("   Caught %s as IoError: %s\n", CaughtException.type->name, CaughtException.message);
+        caught_io = IsInstanceOf(&CaughtException, FileNotFoundError) && IsInstanceOf(&CaughtException, RuntimeError);
+    }
+    EndTry;
+
+    // A parent is not an instance of its subtypes, the exception goes to the outer Try
+    Try {
+        Try {
+            ThrowType(RuntimeError, "too generic for IoError");
+        }
+        CatchType(IoError) {
+            caught_sibling = 1;
+        }
+        EndTry;
+    }
+    CatchType(RuntimeError) {
+        caught_outer = 1;
+    }
+    EndTry;
+
+    // Plain integer codes are of the root type
+    Try {
+        Throw(XCEPTEST_ERR_GENERIC_FAILURE, "plain code");
+    }
+    CatchType(RuntimeError) {
+        caught_sibling = 1;
+    }
+    CatchType(Exception) {
+        caught_root = CaughtException.code == XCEPTEST_ERR_GENERIC_FAILURE;
+    }
+    EndTry;
+
+    // Types with an explicit code still match a plain Catch
+    Try {
+        ThrowType(TimeoutError, "typed timeout");
+    }
+    Catch(XCEPTEST_ERR_TYPED_TIMEOUT) {
+        caught_code = IsInstanceOf(&CaughtException, IoError);
+    }
+    EndTry;
+
+    // A type deeper than XCEP_CONF_TYPE_MAX_DEPTH is never resolved, each of its throws becomes XCEP_ERR_TYPE_DEPTH
+    int depth_ok = 1;
+#if XCEP_CONF_TYPE_MAX_DEPTH == 8
+    volatile int caught_deepest = 0;
+    volatile int too_deep = 0;
+    Try {
+        ThrowType(DeepError7, "deepest allowed");
+    }
+    CatchType(IoError) {
+        caught_deepest = IsInstanceOf(&CaughtException, DeepError4);
+    }
+    EndTry;
+    for (volatile int i = 0; i < 2; ++i) {
+        Try {
+            ThrowType(DeepError8, "one level too deep");
+        }
+        Catch(XCEP_ERR_TYPE_DEPTH) {
+            too_deep++;
+        }
+        EndTry;
+    }
+    depth_ok = caught_deepest && too_deep == 2 && XCEP_TYPE(DeepError8)->state == XCEP___TYPE_UNRESOLVED;
+#endif
+
+    return caught_io && caught_outer && caught_root && caught_code && !caught_sibling && depth_ok
+        && XCEP_TYPE(FileNotFoundError)->depth == 3 && XCEP_TYPE(LogicError)->state == XCEP___TYPE_UNRESOLVED;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 18: CatchAny, CatchIn and CatchRange clauses
+// =======================================================
+
+int catch_dispatch(const int code) {
+    static const XCEP_t_Int retry_codes[] = { 200, 201, 202, 203, 204, 205, 206, 207, 208 };
+    volatile int action = 0;
+
+    Try {
+        Throw(code, "dispatched");
+    }
+    CatchAny(XCEPTEST_ERR_FILE_NOT_FOUND, XCEPTEST_ERR_NETWORK_TIMEOUT) {
+        action = 1;
+    }
+    CatchRange(XCEPTEST_ERR_IO_FIRST, XCEPTEST_ERR_IO_LAST) {
+        action = 2;
+    }
+    CatchIn(retry_codes, sizeof(retry_codes) / sizeof(retry_codes[0])) {
+        action = 3;
+    }
+    CatchAll {
+        action = 4;
+    }
+    EndTry;
+
+    return action;
+}
+
+int test_catch_any_range() {
+    static const struct { int code; int action; } cases[] = {
+        { XCEPTEST_ERR_FILE_NOT_FOUND, 1 }, { XCEPTEST_ERR_NETWORK_TIMEOUT, 1 },
+        { XCEPTEST_ERR_IO_FIRST, 2 }, { 125, 2 }, { XCEPTEST_ERR_IO_LAST, 2 },
+        { 200, 3 }, { 203, 3 }, { 208, 3 },
+        { XCEPTEST_ERR_GENERIC_FAILURE, 4 }, { XCEPTEST_ERR_IO_FIRST - 1, 4 }, { XCEPTEST_ERR_IO_LAST + 1, 4 }, { 209, 4 },
+    };
+    int ok = 1;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        const int action = catch_dispatch(cases[i].code);
+        if (action != cases[i].action) {
+            printf("   Code %d dispatched to %d instead of %d\n", cases[i].code, action, cases[i].action);
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+// =======================================================
+// MARK: Test case 19: ThrowF messages in the per-thread arena
+// =======================================================
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+
+#define XCEPTEST_MESSAGE_SLOTS (XCEP_CONF_MESSAGE_ARENA_SIZE / XCEP_CONF_MESSAGE_MAX_SIZE)
+
+static volatile int XCEPTEST_g_pinned_ok;
+
+// inLevels nested Catch blocks each pin the slot of their message, then one more ThrowF
+static void pin_slots(int inLevels) {
+    Try {
+        ThrowF(XCEPTEST_ERR_FORMATTED, "level %d", inLevels);
+    }
+    Catch(XCEPTEST_ERR_FORMATTED) {
+        const char* message = CaughtException.message;
+        if (inLevels > 1) {
+            pin_slots(inLevels - 1);
+        }
+        else {
+            // Every slot is pinned, the format is thrown as is
+            Try {
+                ThrowF(XCEPTEST_ERR_GENERIC_FAILURE, "%d slots pinned", XCEPTEST_MESSAGE_SLOTS);
+            }
+            CatchAll {
+                XCEPTEST_g_pinned_ok = strcmp(CaughtException.message, "%d slots pinned") == 0;
+            }
+            EndTry;
+        }
+        char expected[16];
+        snprintf(expected, sizeof(expected), "level %d", inLevels);
+        XCEPTEST_g_pinned_ok = XCEPTEST_g_pinned_ok && strcmp(message, expected) == 0;
+    }
+    EndTry;
+}
+
+int test_throw_formatted() {
+    const char* volatile outer_message = NULL;
+    volatile int rethrown_ok = 0;
+    volatile int nested_ok = 0;
+    volatile int pinned_rethrow_ok = 0;
+    volatile int truncated_ok = 0;
+
+    // The message survives a Rethrow
+    Try {
+        Try {
+            ThrowF(XCEPTEST_ERR_FORMATTED, "offset %d in %s", 42, "input.json");
+        }
+        Catch(XCEPTEST_ERR_FORMATTED) {
+            Rethrow;
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_FORMATTED) {
+        printf("   Caught formatted: %s\n", CaughtException.message);
+        rethrown_ok = strcmp(CaughtException.message, "offset 42 in input.json") == 0;
+    }
+    EndTry;
+
+    // And a nested ThrowF caught inside the Catch handling it
+    Try {
+        ThrowF(XCEPTEST_ERR_FORMATTED, "outer %s", "message");
+    }
+    Catch(XCEPTEST_ERR_FORMATTED) {
+        outer_message = CaughtException.message;
+        Try {
+            ThrowF(XCEPTEST_ERR_GENERIC_FAILURE, "nested %d", 7);
+        }
+        CatchAll {
+            nested_ok = strcmp(CaughtException.message, "nested 7") == 0;
+        }
+        EndTry;
+        nested_ok = nested_ok && strcmp(outer_message, "outer message") == 0;
+    }
+    EndTry;
+
+    // More nested ThrowF than slots: the slot of the message being handled is skipped, Rethrow still sends it
+    Try {
+        Try {
+            ThrowF(XCEPTEST_ERR_FORMATTED, "handled %s", "message");
+        }
+        Catch(XCEPTEST_ERR_FORMATTED) {
+            outer_message = CaughtException.message;
+            for (volatile int i = 0; i < XCEPTEST_MESSAGE_SLOTS * 2; i++) {
+                Try {
+                    ThrowF(XCEPTEST_ERR_GENERIC_FAILURE, "retry %d", i);
+                }
+                CatchAll {
+                }
+                EndTry;
+            }
+            pinned_rethrow_ok = strcmp(outer_message, "handled message") == 0;
+            Rethrow;
+        }
+        EndTry;
+    }
+    CatchAll {
+        pinned_rethrow_ok = pinned_rethrow_ok && CaughtException.code == XCEPTEST_ERR_FORMATTED
+            && strcmp(CaughtException.message, "handled message") == 0;
+    }
+    EndTry;
+
+    // With every slot pinned by a Catch, a ThrowF falls back to its format
+    XCEPTEST_g_pinned_ok = 0;
+    pin_slots(XCEPTEST_MESSAGE_SLOTS);
+    printf("   Slots pinned: %d, rethrown: %d\n", XCEPTEST_g_pinned_ok, pinned_rethrow_ok);
+
+    // Longer messages are cut at XCEP_CONF_MESSAGE_MAX_SIZE - 1 characters
+    char long_text[XCEP_CONF_MESSAGE_MAX_SIZE * 2];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    Try {
+        ThrowF(XCEPTEST_ERR_FORMATTED, "%s", long_text);
+    }
+    Catch(XCEPTEST_ERR_FORMATTED) {
+        const char* message = CaughtException.message;
+        truncated_ok = strlen(message) == XCEP_CONF_MESSAGE_MAX_SIZE - 1;
+#if XCEP_CONF_MESSAGE_TRUNCATION == XCEP_TRUNCATE_ELLIPSIS
+        truncated_ok = truncated_ok && strcmp(message + XCEP_CONF_MESSAGE_MAX_SIZE - 4, "...") == 0;
+#endif
+    }
+    EndTry;
+
+    return rethrown_ok && nested_ok && pinned_rethrow_ok && XCEPTEST_g_pinned_ok && truncated_ok;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 20: Typed payloads with ThrowWith
+// =======================================================
+
+#if XCEP_CONF_PAYLOAD_SIZE
+
+typedef struct {
+    long offset;
+    char token[16];
+    int error_number;
+} XCEPTEST_t_ParseError;
+
+void parse_failing_at(const long offset) {
+    ThrowWith(XCEPTEST_ERR_PAYLOAD, "unexpected token", ((XCEPTEST_t_ParseError){ offset, "}", 22 }));
+}
+
+int test_throw_with_payload() {
+    volatile int payload_ok = 0;
+    volatile int plain_ok = 0;
+
+    Try {
+        parse_failing_at(1337);
+    }
+    Catch(XCEPTEST_ERR_PAYLOAD) {
+        const XCEPTEST_t_ParseError* error = CaughtPayload(XCEPTEST_t_ParseError);
+        if (error) {
+            printf("   Payload: offset %ld, token '%s', errno %d\n", error->offset, error->token, error->error_number);
+            payload_ok = error->offset == 1337 && strcmp(error->token, "}") == 0 && error->error_number == 22;
+        }
+        // A payload read with the wrong size is refused
+        payload_ok = payload_ok && CaughtPayload(int) == NULL;
+    }
+    EndTry;
+
+    // A plain Throw after it carries no payload
+    Try {
+        Throw(XCEPTEST_ERR_GENERIC_FAILURE, "no payload");
+    }
+    CatchAll {
+        plain_ok = CaughtPayload(XCEPTEST_t_ParseError) == NULL && CaughtException.payload_size == 0;
+    }
+    EndTry;
+
+    return payload_ok && plain_ok;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 21: Sampled backtrace capture
+// =======================================================
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+
+XCEPTEST_NOINLINE void backtrace_leaf(void) {
+    Throw(XCEPTEST_ERR_BACKTRACE, "thrown 3 calls deep");
+}
+
+XCEPTEST_NOINLINE void backtrace_middle(void) {
+    backtrace_leaf();
+}
+
+XCEPTEST_NOINLINE void backtrace_root(void) {
+    backtrace_middle();
+}
+
+int test_backtrace_sampling() {
+    XCEP_t_Uint sizes[4] = { 0 };
+
+    XCEP_SetBacktraceSampling(2);
+    for (volatile int i = 0; i < 4; ++i) {
+        Try {
+            backtrace_root();
+        }
+        Catch(XCEPTEST_ERR_BACKTRACE) {
+            sizes[i] = XCEP_GetContext()->backtrace_size;
+            if (i == 0) XCEP_PrintException("   Sampled", &CaughtException);
+        }
+        EndTry;
+    }
+    XCEP_SetBacktraceSampling(XCEP_CONF_BACKTRACE_SAMPLING);
+
+    printf("   Captured %u, %u, %u, %u frames\n", (unsigned)sizes[0], (unsigned)sizes[1], (unsigned)sizes[2], (unsigned)sizes[3]);
+
+    // 1 throw in 2: the leaf, middle, root and test frames are all below XCEP's own ones
+    return sizes[0] >= 4 && sizes[1] == 0 && sizes[2] == sizes[0] && sizes[3] == 0;
+}
 
-#if XCEP_CONF_ENABLE_THREAD_SAFE
-    XCEPTEST_RUN_TEST(test_thread_safety_scalable);
-#else
-    printf("===== Warnings =====\n");
-    printf("   Thread safety tests are disabled.\n");
 #endif
 
+// =======================================================
+// MARK: Test case 22: Per-throw-site statistics
+// =======================================================
+
+#if XCEP_CONF_ENABLE_STATS
+
+#define XCEPTEST_STATS_THREADS 4
+#define XCEPTEST_STATS_THROWS 1000
+
+void stats_throwing_site(void) {
+    Throw(XCEPTEST_ERR_STATS, "counted");
+}
+
+void* stats_thread_worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < XCEPTEST_STATS_THROWS; ++i) {
+        Try {
+            stats_throwing_site();
+        }
+        Catch(XCEPTEST_ERR_STATS) { }
+        EndTry;
+    }
+    return NULL;
+}
+
+int stats_site_counters(long long counters[XCEP_STATS_COUNT]) {
+    XCEP_t_SiteStats stats[64];
+    const size_t count = XCEP_StatsSnapshot(stats, 64);
+    for (size_t i = 0; i < count && i < 64; ++i) {
+        if (strcmp(stats[i].site->function, "stats_throwing_site") == 0) {
+            memcpy(counters, stats[i].counters, sizeof(stats[i].counters));
+            return stats[i].site->code == XCEPTEST_ERR_STATS;
+        }
+    }
+    return 0;
+}
+
+int test_throw_site_stats() {
+    long long before[XCEP_STATS_COUNT] = { 0 };
+    long long after[XCEP_STATS_COUNT] = { 0 };
+
+    // Registers the site
+    stats_thread_worker(NULL);
+    if (!stats_site_counters(before)) return 0;
+
+    // One caught, one rethrown then caught, one replaced by a throw in Catch
+    Try {
+        Try {
+            stats_throwing_site();
+        }
+        Catch(XCEPTEST_ERR_STATS) {
+            Rethrow;
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_STATS) { }
+    EndTry;
+
+    Try {
+        Try {
+            stats_throwing_site();
+        }
+        Catch(XCEPTEST_ERR_STATS) {
+            // Throw is still an expression with a site descriptor
+            CaughtException.code == XCEPTEST_ERR_STATS ? Throw(XCEPTEST_ERR_GENERIC_FAILURE, "replaces the counted one") : (void)0;
+        }
+        EndTry;
+    }
+    CatchAll { }
+    EndTry;
+
+    XCEPTEST_t_Thread threads[XCEPTEST_STATS_THREADS];
+    for (int i = 0; i < XCEPTEST_STATS_THREADS; ++i) {
+        XCEPTEST_ThreadCreate(&threads[i], stats_thread_worker, NULL);
+    }
+    for (int i = 0; i < XCEPTEST_STATS_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+    }
+
+    stats_site_counters(after);
+    const long long thrown = after[XCEP_STATS_THROWN] - before[XCEP_STATS_THROWN];
+    const long long caught = after[XCEP_STATS_CAUGHT] - before[XCEP_STATS_CAUGHT];
+    const long long rethrown = after[XCEP_STATS_RETHROWN] - before[XCEP_STATS_RETHROWN];
+    printf("   Site counted %lld thrown, %lld caught, %lld rethrown\n", thrown, caught, rethrown);
+
+    const long long expected = 2 + XCEPTEST_STATS_THREADS * XCEPTEST_STATS_THROWS;
+    return before[XCEP_STATS_THROWN] == XCEPTEST_STATS_THROWS && before[XCEP_STATS_CAUGHT] == XCEPTEST_STATS_THROWS
+        && thrown == expected && caught == expected && rethrown == 1
+        && after[XCEP_STATS_UNCAUGHT] == 0;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 23: Asynchronous logging ring
+// =======================================================
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+
+#define XCEPTEST_LOG_THREADS 4
+#define XCEPTEST_LOG_THROWS 500
+
+void* log_thread_worker(void* arg) {
+    (void)arg;
+    for (volatile int i = 0; i < XCEPTEST_LOG_THROWS; ++i) {
+        Try {
+            ThrowF(XCEPTEST_ERR_LOGGED, "logged %d", i);
+        }
+        Catch(XCEPTEST_ERR_LOGGED) { }
+        EndTry;
+    }
+    return NULL;
+}
+
+int test_async_log() {
+    FILE* output = tmpfile();
+    if (output == NULL) return 0;
+
+    const long long dropped_before = XCEP_LogDropped();
+    if (XCEP_LogStart(output) != 0) return 0;
+
+    XCEPTEST_t_Thread threads[XCEPTEST_LOG_THREADS];
+    for (int i = 0; i < XCEPTEST_LOG_THREADS; ++i) {
+        XCEPTEST_ThreadCreate(&threads[i], log_thread_worker, NULL);
+    }
+    for (int i = 0; i < XCEPTEST_LOG_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+    }
+    XCEP_PrintException("Printed", &XCEP_NewException(XCEPTEST_ERR_LOGGED, "printed once"));
+#if XCEP_CONF_BACKTRACE_DEPTH
+    // The ring is emptied first, the record carrying the frames cannot be dropped
+    XCEP_LogFlush();
+    Try {
+        Throw(XCEPTEST_ERR_LOGGED, "printed with frames");
+    }
+    Catch(XCEPTEST_ERR_LOGGED) {
+        XCEP_PrintException("Printed", &CaughtException);
+    }
+    EndTry;
+#endif
+    XCEP_LogStop();
+
+    // Every record is either written, one line each, or counted as dropped
+    int thrown_lines = 0;
+    int printed_lines = 0;
+    int frame_lines = 0;
+    char line[512];
+    rewind(output);
+    while (fgets(line, sizeof(line), output)) {
+        if (strncmp(line, "Thrown (116) caused by: \"logged ", 32) == 0) thrown_lines++;
+        if (strncmp(line, "Printed (116) caused by: \"printed once\"", 39) == 0) printed_lines++;
+        if (strncmp(line, "\t#", 2) == 0) frame_lines++;
+    }
+    fclose(output);
+
+    const long long dropped = XCEP_LogDropped() - dropped_before;
+    printf("   %d throws written, %lld dropped, %d frames\n", thrown_lines, dropped, frame_lines);
+#if XCEP_CONF_BACKTRACE_DEPTH
+    if (frame_lines == 0) return 0;
+#else
+    if (frame_lines != 0) return 0;
+#endif
+    return thrown_lines + printed_lines + dropped == XCEPTEST_LOG_THREADS * XCEPTEST_LOG_THROWS + 1;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 24: Exceptions captured and rethrown across threads
+// =======================================================
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+
+typedef struct {
+    int id;
+    XCEP_t_ExceptionPtr error;
+} XCEPTEST_t_CaptureJob;
+
+void* capture_thread_worker(void* arg) {
+    XCEPTEST_t_CaptureJob* job = arg;
+    job->error.has_exception = XCEP_FALSE;
+    Try {
+#if XCEP_CONF_PAYLOAD_SIZE
+        ThrowWith(XCEPTEST_ERR_CROSS_THREAD, "failed in worker", job->id);
+#else
+        Throw(XCEPTEST_ERR_CROSS_THREAD, "failed in worker");
+#endif
+    }
+    CatchAll {
+        XCEP_CaptureException(&job->error);
+    }
+    EndTry;
+    return NULL;
+}
+
+int test_exception_ptr() {
+    XCEPTEST_t_CaptureJob job = { .id = 42 };
+    volatile int rethrown_ok = 0;
+
+    XCEPTEST_t_Thread thread;
+    XCEPTEST_ThreadCreate(&thread, capture_thread_worker, &job);
+    XCEPTEST_ThreadJoin(thread);
+
+    Try {
+        if (job.error.has_exception) XCEP_RethrowCaptured(&job.error);
+    }
+    Catch(XCEPTEST_ERR_CROSS_THREAD) {
+        printf("   Rethrown from worker: %s\n", CaughtException.message);
+        rethrown_ok = strcmp(CaughtException.message, "failed in worker") == 0;
+#if XCEP_CONF_PAYLOAD_SIZE
+        rethrown_ok = rethrown_ok && CaughtPayload(int) && *CaughtPayload(int) == 42;
+#endif
+    }
+    EndTry;
+
+    return rethrown_ok;
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API
+
+void joined_thread_function(void* arg) {
+    ThrowF(XCEPTEST_ERR_CROSS_THREAD, "worker %d gave up", *(int*)arg);
+}
+
+void quiet_thread_function(void* arg) {
+    (*(int*)arg)++;
+}
+
+int test_thread_join_rethrow() {
+    int failing_id = 7;
+    int counter = 0;
+    volatile int rethrown_ok = 0;
+    volatile int quiet_ok = 0;
+    XCEP_t_Thread failing;
+    XCEP_t_Thread quiet;
+
+    Try {
+        XCEP_ThreadStart(&quiet, quiet_thread_function, &counter);
+        XCEP_ThreadJoin(&quiet);
+        quiet_ok = counter == 1;
+
+        XCEP_ThreadStart(&failing, joined_thread_function, &failing_id);
+        XCEP_ThreadJoin(&failing);
+    }
+    Catch(XCEPTEST_ERR_CROSS_THREAD) {
+        printf("   Join rethrew: %s\n", CaughtException.message);
+        rethrown_ok = strcmp(CaughtException.message, "worker 7 gave up") == 0;
+    }
+    EndTry;
+
+    return quiet_ok && rethrown_ok;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 25: Task groups, first-exception cancellation
+// =======================================================
+
+#if XCEP_CONF_ENABLE_THREAD_API
+
+#define XCEPTEST_TASK_INDICES 100000
+
+#define XCEPTEST_TASK_ROWS 64
+#define XCEPTEST_TASK_COLUMNS 1000
+
+typedef struct {
+    unsigned char visited[XCEPTEST_TASK_INDICES]; // Every index is written by one task only
+    long fail_at;
+    XCEP_t_TaskGroup* group; // Of the nested ParallelFor
+} XCEPTEST_t_VisitJob;
+
+typedef struct {
+    XCEPTEST_t_VisitJob* job;
+    long row;
+} XCEPTEST_t_RowJob;
+
+void visit_index(long index, void* arg) {
+    XCEPTEST_t_VisitJob* job = arg;
+    if (index == job->fail_at) ThrowF(XCEPTEST_ERR_TASK, "index %ld failed", index);
+    job->visited[index]++;
+}
+
+void visit_column(long index, void* arg) {
+    const XCEPTEST_t_RowJob* row_job = arg;
+    visit_index(row_job->row * XCEPTEST_TASK_COLUMNS + index, row_job->job);
+}
+
+// A ParallelFor in a task of the same group, it waits for its own columns only
+void visit_row(long row, void* arg) {
+    XCEPTEST_t_RowJob row_job = { arg, row };
+    XCEP_ParallelFor(row_job.job->group, 0, XCEPTEST_TASK_COLUMNS, 64, visit_column, &row_job);
+}
+
+void failing_task(void* arg) {
+    ThrowF(XCEPTEST_ERR_TASK + *(int*)arg, "task %d failed", *(int*)arg);
+}
+
+// Only ends once the failure of another task cancelled the group
+void spinning_task(void* arg) {
+    (void)arg;
+    for (;;) XCEP_CheckCancel();
+}
+
+void counting_task(void* arg) {
+    (*(int*)arg)++;
+}
+
+int XCEPTEST_g_inline_reached = 0;
+
+// Pushed onto a full deque, it runs on the pushing thread before any XCEP_TaskGroupWait
+void cancelling_task(void* arg) {
+    XCEP_TaskGroupCancel(arg);
+    XCEP_CheckCancel();
+    XCEPTEST_g_inline_reached = 1;
+}
+
+int test_task_group() {
+    static XCEP_t_TaskGroup group;
+    static XCEPTEST_t_VisitJob job = { { 0 }, -1 };
+    volatile int visit_ok = 1;
+    volatile int nested_ok = 1;
+    volatile int nested_failed_ok = 0;
+    volatile int first_ok = 0;
+    volatile int all_ok = 0;
+    int counted = 0;
+
+    if (XCEP_TaskGroupInit(&group, 4, XCEP_TASK_RETHROW_FIRST) != 0) return 0;
+
+    XCEP_ParallelFor(&group, 0, XCEPTEST_TASK_INDICES, 64, visit_index, &job);
+    for (int i = 0; i < XCEPTEST_TASK_INDICES; ++i) visit_ok = visit_ok && job.visited[i] == 1;
+
+    memset(job.visited, 0, sizeof(job.visited));
+    job.group = &group;
+    XCEP_ParallelFor(&group, 0, XCEPTEST_TASK_ROWS, 1, visit_row, &job);
+    for (int i = 0; i < XCEPTEST_TASK_INDICES; ++i) {
+        nested_ok = nested_ok && job.visited[i] == (i < XCEPTEST_TASK_ROWS * XCEPTEST_TASK_COLUMNS);
+    }
+
+    Try {
+        int id = 0;
+        XCEP_TaskGroupRun(&group, spinning_task, NULL);
+        XCEP_TaskGroupRun(&group, spinning_task, NULL);
+        XCEP_TaskGroupRun(&group, failing_task, &id);
+        XCEP_TaskGroupWait(&group);
+    }
+    Catch(XCEPTEST_ERR_TASK) {
+        printf("   First exception: %s\n", CaughtException.message);
+        first_ok = strcmp(CaughtException.message, "task 0 failed") == 0 && group.failed == 1;
+    }
+    EndTry;
+
+    job.fail_at = 5000;
+    Try {
+        XCEP_ParallelFor(&group, 0, XCEPTEST_TASK_INDICES, 64, visit_index, &job);
+    }
+    Catch(XCEPTEST_ERR_TASK) {
+        first_ok = first_ok && strcmp(CaughtException.message, "index 5000 failed") == 0;
+    }
+    EndTry;
+
+    // A failure in a nested ParallelFor reaches the outermost wait
+    job.fail_at = 7 * XCEPTEST_TASK_COLUMNS + 3;
+    Try {
+        XCEP_ParallelFor(&group, 0, XCEPTEST_TASK_ROWS, 1, visit_row, &job);
+    }
+    Catch(XCEPTEST_ERR_TASK) {
+        printf("   Nested exception: %s\n", CaughtException.message);
+        nested_failed_ok = strcmp(CaughtException.message, "index 7003 failed") == 0;
+    }
+    EndTry;
+    XCEP_TaskGroupDestroy(&group);
+
+    if (XCEP_TaskGroupInit(&group, 3, XCEP_TASK_RETHROW_ALL) != 0) return 0;
+    Try {
+        int ids[3] = { 1, 2, 3 };
+        for (int i = 0; i < 3; ++i) XCEP_TaskGroupRun(&group, failing_task, &ids[i]);
+        XCEP_TaskGroupWait(&group);
+    }
+    Catch(XCEP_ERR_TASKS_FAILED) {
+        int codes = 0;
+        for (long i = 0; i < group.failed; ++i) codes |= 1 << (group.errors[i].exception.code - XCEPTEST_ERR_TASK);
+        printf("   All exceptions: %s\n", CaughtException.message);
+        all_ok = group.failed == 3 && codes == (1 << 1 | 1 << 2 | 1 << 3);
+    }
+    EndTry;
+    XCEP_TaskGroupDestroy(&group);
+
+    // No other worker empties the deque, the task after a full one runs inline and the next is skipped
+    if (XCEP_TaskGroupInit(&group, 1, XCEP_TASK_RETHROW_FIRST) != 0) return 0;
+    for (int i = 0; i < XCEP_CONF_TASK_QUEUE_SIZE; ++i) XCEP_TaskGroupRun(&group, counting_task, &counted);
+    XCEP_TaskGroupRun(&group, cancelling_task, &group);
+    XCEP_TaskGroupRun(&group, counting_task, &counted);
+    XCEP_TaskGroupWait(&group);
+    XCEP_TaskGroupDestroy(&group);
+    const int inline_ok = !XCEPTEST_g_inline_reached && counted == 0;
+    printf("   Inline task %s, %d queued task(s) ran\n", XCEPTEST_g_inline_reached ? "ran past the cancel" : "cancelled", counted);
+
+    return visit_ok && nested_ok && nested_failed_ok && first_ok && all_ok && inline_ok;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 26: Faults turned into exceptions
+// =======================================================
+
+#if XCEP_CONF_ENABLE_SIGNALS
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+volatile int XCEPTEST_g_fault_zero = 0;
+int* volatile XCEPTEST_g_fault_null = NULL;
+
+XCEPTEST_NOINLINE int overflow_stack(const int depth) {
+    volatile char frame[512];
+    frame[0] = (char)depth;
+    if (XCEPTEST_g_fault_zero < 0) return 0;
+    return overflow_stack(depth + 1) + frame[0];
+}
+
+// A fault outside of any Try must kill the process as it would without XCEP
+int fault_outside_try_kills() {
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0) {
+        *XCEPTEST_g_fault_null = 1;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV;
+}
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+
+// Faults on a thread of its own, then returns the alternate stack it ran on
+void* signal_thread_worker(void* arg) {
+    volatile int* caught = arg;
+    if (XCEP_SignalsThreadInit() != 0) return NULL;
+    Try {
+        *XCEPTEST_g_fault_null = 1;
+    }
+    Catch(XCEP_ERR_SEGFAULT) {
+        *caught = 1;
+    }
+    EndTry;
+
+    stack_t current;
+    if (sigaltstack(NULL, &current) != 0 || (current.ss_flags & SS_DISABLE)) return NULL;
+    return current.ss_sp;
+}
+
+// The stack is mapped for the thread only, msync fails with ENOMEM once its pages are unmapped
+int signal_stack_released() {
+    volatile int caught = 0;
+    pthread_t thread;
+    void* stack = NULL;
+    if (pthread_create(&thread, NULL, signal_thread_worker, (void*)&caught) != 0) return 0;
+    pthread_join(thread, &stack);
+    if (stack == NULL) return 0;
+
+    const int unmapped = msync(stack, XCEP_CONF_SIGNAL_STACK_SIZE, MS_ASYNC) != 0 && errno == ENOMEM;
+    printf("   Thread fault caught %d, its stack %s\n", caught, unmapped ? "unmapped" : "still mapped");
+    return caught && unmapped;
+}
+
+#endif
+
+int test_signal_exceptions() {
+    volatile int segv_count = 0;
+    volatile int fpe_ok = 0;
+    volatile int bus_ok = 0;
+    volatile int overflow_ok = 0;
+    volatile int address_ok = 1;
+
+    if (XCEP_SignalsInstall() != 0) return 0;
+
+    // Every iteration needs SIGSEGV unblocked again by the previous jump
+    for (int i = 0; i < 100; ++i) {
+        Try {
+            *XCEPTEST_g_fault_null = i;
+        }
+        Catch(XCEP_ERR_SEGFAULT) {
+            segv_count++;
+#if XCEP_CONF_PAYLOAD_SIZE
+            address_ok = address_ok && CaughtPayload(XCEP_t_SignalInfo) && CaughtPayload(XCEP_t_SignalInfo)->address == NULL;
+#endif
+        }
+        EndTry;
+    }
+
+    Try {
+#if defined(__x86_64__) || defined(__i386__)
+        XCEPTEST_g_fault_zero = 10 / XCEPTEST_g_fault_zero;
+#else
+        raise(SIGFPE); // Integer division by zero does not trap on every architecture
+#endif
+    }
+    Catch(XCEP_ERR_FPE) {
+        printf("   %s\n", CaughtException.message);
+        fpe_ok = 1;
+    }
+    EndTry;
+
+    // Reading a page past the end of a mapped file raises SIGBUS
+    FILE* file = tmpfile();
+    volatile char* mapping = file ? mmap(NULL, 4096, PROT_READ, MAP_SHARED, fileno(file), 0) : MAP_FAILED;
+    if (mapping != MAP_FAILED) {
+        Try {
+            XCEPTEST_g_fault_zero = mapping[0];
+        }
+        Catch(XCEP_ERR_BUS_ERROR) {
+            printf("   %s\n", CaughtException.message);
+            bus_ok = 1;
+        }
+        EndTry;
+        munmap((void*)mapping, 4096);
+    }
+    if (file) fclose(file);
+
+    // Called through a pointer, GCC proves the recursion nothrow and the unwind backend would lose its landing pad
+    int (*volatile overflow)(int) = overflow_stack;
+    Try {
+        XCEPTEST_g_fault_zero = overflow(0);
+    }
+    Catch(XCEP_ERR_SEGFAULT) {
+        printf("   Stack overflow: %s\n", CaughtException.message);
+        overflow_ok = 1;
+    }
+    EndTry;
+
+    const int fallback_ok = fault_outside_try_kills();
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    const int thread_ok = signal_stack_released();
+#else
+    const int thread_ok = 1;
+#endif
+    XCEP_SignalsUninstall();
+
+    return segv_count == 100 && address_ok && fpe_ok && bus_ok && overflow_ok && fallback_ok && thread_ok;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 27: Fibers migrating between threads inside a Try
+// =======================================================
+
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH && XCEP_CONF_ENABLE_THREAD_SAFE && !defined(_WIN32)
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#define XCEPTEST_FIBER_COUNT 2000
+#define XCEPTEST_FIBER_STACK (32 * 1024)
+#define XCEPTEST_FIBER_CARRIERS 4
+
+typedef struct {
+    ucontext_t context;
+    ucontext_t* carrier;  // Carrier thread that resumed the fiber last
+    XCEP_t_Context xcep;
+    int id;
+    volatile int done;
+    volatile int ok;
+} XCEPTEST_t_Fiber;
+
+typedef struct {
+    XCEPTEST_t_Fiber* fibers;
+    int queue[XCEPTEST_FIBER_COUNT];  // Runnable fibers, a ring protected by lock
+    int head;
+    int count;
+    int finished;
+    int migrations;
+    pthread_mutex_t lock;
+} XCEPTEST_t_Scheduler;
+
+static XCEPTEST_t_Scheduler XCEPTEST_g_scheduler;
+
+XCEPTEST_NOINLINE void fiber_yield(XCEPTEST_t_Fiber* fiber) {
+    swapcontext(&fiber->context, fiber->carrier);
+}
+
+void fiber_main(const int id) {
+    XCEPTEST_t_Fiber* fiber = &XCEPTEST_g_scheduler.fibers[id];
+    char expected[32];
+    snprintf(expected, sizeof(expected), "fiber %d", id);
+
+    Try {
+        fiber_yield(fiber);
+        Try {
+            fiber_yield(fiber);
+            ThrowF(XCEPTEST_ERR_FIBER, "fiber %d", id);
+        }
+        Catch(XCEPTEST_ERR_FIBER) {
+            fiber_yield(fiber);
+            if (strcmp(CaughtException.message, expected) == 0) Rethrow;
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_FIBER) {
+        fiber_yield(fiber);
+        fiber->ok = strcmp(CaughtException.message, expected) == 0 && XCEP_GetContext() == &fiber->xcep;
+    }
+    EndTry;
+
+    fiber->done = 1;
+    fiber_yield(fiber);
+}
+
+void* fiber_carrier(void* arg) {
+    XCEPTEST_t_Scheduler* scheduler = arg;
+    ucontext_t carrier;
+
+    for (;;) {
+        pthread_mutex_lock(&scheduler->lock);
+        if (scheduler->finished == XCEPTEST_FIBER_COUNT) {
+            pthread_mutex_unlock(&scheduler->lock);
+            break;
+        }
+        int id = -1;
+        if (scheduler->count > 0) {
+            id = scheduler->queue[scheduler->head];
+            scheduler->head = (scheduler->head + 1) % XCEPTEST_FIBER_COUNT;
+            scheduler->count--;
+        }
+        pthread_mutex_unlock(&scheduler->lock);
+        if (id < 0) continue;
+
+        XCEPTEST_t_Fiber* fiber = &scheduler->fibers[id];
+        if (fiber->carrier != NULL && fiber->carrier != &carrier) {
+            pthread_mutex_lock(&scheduler->lock);
+            scheduler->migrations++;
+            pthread_mutex_unlock(&scheduler->lock);
+        }
+        fiber->carrier = &carrier;
+        XCEP_ContextSwitch(NULL, &fiber->xcep);
+        swapcontext(&carrier, &fiber->context);
+        XCEP_ContextSwitch(&fiber->xcep, NULL);
+
+        pthread_mutex_lock(&scheduler->lock);
+        if (fiber->done) {
+            scheduler->finished++;
+        } else {
+            scheduler->queue[(scheduler->head + scheduler->count) % XCEPTEST_FIBER_COUNT] = id;
+            scheduler->count++;
+        }
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+    return NULL;
+}
+
+int test_fiber_context_switch() {
+    XCEPTEST_t_Scheduler* scheduler = &XCEPTEST_g_scheduler;
+    char* stacks = malloc((size_t)XCEPTEST_FIBER_COUNT * XCEPTEST_FIBER_STACK);
+    scheduler->fibers = calloc(XCEPTEST_FIBER_COUNT, sizeof(XCEPTEST_t_Fiber));
+    if (stacks == NULL || scheduler->fibers == NULL) return 0;
+    pthread_mutex_init(&scheduler->lock, NULL);
+
+    for (int i = 0; i < XCEPTEST_FIBER_COUNT; ++i) {
+        XCEPTEST_t_Fiber* fiber = &scheduler->fibers[i];
+        fiber->id = i;
+        XCEP_ContextInit(&fiber->xcep);
+        getcontext(&fiber->context);
+        fiber->context.uc_stack.ss_sp = stacks + (size_t)i * XCEPTEST_FIBER_STACK;
+        fiber->context.uc_stack.ss_size = XCEPTEST_FIBER_STACK;
+        fiber->context.uc_link = NULL;
+        makecontext(&fiber->context, (void (*)(void))fiber_main, 1, i);
+        scheduler->queue[i] = i;
+    }
+    scheduler->count = XCEPTEST_FIBER_COUNT;
+
+    pthread_t carriers[XCEPTEST_FIBER_CARRIERS];
+    for (int i = 0; i < XCEPTEST_FIBER_CARRIERS; ++i) pthread_create(&carriers[i], NULL, fiber_carrier, scheduler);
+    for (int i = 0; i < XCEPTEST_FIBER_CARRIERS; ++i) pthread_join(carriers[i], NULL);
+
+    int ok_count = 0;
+    for (int i = 0; i < XCEPTEST_FIBER_COUNT; ++i) ok_count += scheduler->fibers[i].ok;
+    printf("   %d/%d fibers caught their own exception, %d migrations\n", ok_count, XCEPTEST_FIBER_COUNT, scheduler->migrations);
+
+    pthread_mutex_destroy(&scheduler->lock);
+    free(scheduler->fibers);
+    free(stacks);
+    return ok_count == XCEPTEST_FIBER_COUNT && XCEP_GetContext() == &XCEP_g_Context;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 28: Results checked in loops, thrown at the boundary
+// =======================================================
+
+XCEPTEST_NOINLINE XCEP_t_Result parse_digit(const char c) {
+    if (c < '0' || c > '9') return Fail(XCEPTEST_ERR_RESULT, "not a digit");
+    return Ok();
+}
+
+XCEPTEST_NOINLINE XCEP_t_Result parse_number(const char* text, int* out_digits) {
+    *out_digits = 0;
+    for (; *text; ++text) {
+        Check(parse_digit(*text));
+        (*out_digits)++;
+    }
+    return Ok();
+}
+
+int test_result_escalation() {
+    int digits = 0;
+    volatile int valid_ok = 0;
+    volatile int thrown_ok = 0;
+    volatile int round_trip_ok = 0;
+
+    Try {
+        TryResult(parse_number("12345", &digits));
+        valid_ok = digits == 5;
+        TryResult(parse_number("12x45", &digits));
+    }
+    Catch(XCEPTEST_ERR_RESULT) {
+        thrown_ok = digits == 2 && strcmp(CaughtException.message, "not a digit") == 0;
+        const t_Result result = CaughtResult;
+        round_trip_ok = result.code == XCEPTEST_ERR_RESULT && result.message == CaughtException.message;
+    }
+    EndTry;
+
+    return valid_ok && thrown_ok && round_trip_ok;
+}
+
+#if XCEP_CONF_STRICT_THROW
+
+#include <setjmp.h>
+
+// =======================================================
+// MARK: Test case 29: Strict throw, uncaught handlers jump away
+// =======================================================
+
+static jmp_buf XCEPTEST_g_strict_escape;
+
+void XCEPTEST_strict_handler(const XCEP_t_Exception* ex) {
+    printf("   Strict handler leaving for code %d\n", ex->code);
+    longjmp(XCEPTEST_g_strict_escape, 1);
+}
+
+int test_strict_uncaught_handler() {
+    static volatile int escaped = 0;
+    const XCEP_t_ExceptionHandler original_handler = XCEP_g_UncaughtExceptionHandler;
+    SetUncaughtExceptionHandler(XCEPTEST_strict_handler);
+    if (setjmp(XCEPTEST_g_strict_escape) == 0) {
+        Throw(XCEPTEST_ERR_RESULT, "no Try around");
+    } else {
+        escaped = 1;
+    }
+    SetUncaughtExceptionHandler(original_handler);
+    return escaped;
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+
+// =======================================================
+// MARK: Test case 30: Compact throw sites looked up in the xcep_sites section
+// =======================================================
+
+static int XCEPTEST_g_compact_line = 0;
+
+XCEPTEST_NOINLINE void compact_site_thrower(const int first) {
+    if (first) {
+        XCEPTEST_g_compact_line = __LINE__; Throw(XCEPTEST_ERR_COMPACT_SITE, "first site");
+    }
+    Throw(XCEPTEST_ERR_COMPACT_SITE, "second site");
+}
+
+int test_compact_sites() {
+    volatile XCEP_t_Uint first_id = 0;
+    volatile XCEP_t_Uint second_id = 0;
+    volatile int lookup_ok = 0;
+
+    printf("   sizeof(XCEP_t_Exception)=%u, %u site records\n", (unsigned)sizeof(XCEP_t_Exception), XCEP_SiteCount());
+
+    Try {
+        compact_site_thrower(1);
+    }
+    Catch(XCEPTEST_ERR_COMPACT_SITE) {
+        first_id = CaughtException.site_id;
+        const XCEP_t_SiteRecord* site = XCEP_SiteLookup(first_id);
+        lookup_ok = site != NULL && site->line == XCEPTEST_g_compact_line
+            && strcmp(site->function, "compact_site_thrower") == 0 && strstr(site->file, "XCEPTEST_test.c") != NULL;
+        PrintException("Compact site", &CaughtException);
+    }
+    EndTry;
+
+    Try {
+        compact_site_thrower(0);
+    }
+    Catch(XCEPTEST_ERR_COMPACT_SITE) {
+        second_id = CaughtException.site_id;
+    }
+    EndTry;
+
+    // The code and the site id share the first 8 bytes
+    const int packed_ok = offsetof(XCEP_t_Exception, site_id) == sizeof(XCEP_t_Int) && sizeof(XCEP_t_Int) + sizeof(XCEP_t_Uint) == 8;
+    const int bounds_ok = XCEP_SiteLookup(0) == NULL && XCEP_SiteLookup(XCEP_SiteCount() + 1) == NULL;
+    return lookup_ok && first_id != 0 && second_id != 0 && first_id != second_id && packed_ok && bounds_ok;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 31: Random nested programs against a reference interpreter
+// =======================================================
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "XCEPTEST_random.h"
+
+#define XCEPTEST_RANDOM_THREADS 4
+
+typedef struct {
+    unsigned long long seed;
+    long count;
+    XCEPTEST_t_RandomStats stats;
+} XCEPTEST_t_RandomJob;
+
+#if defined(_WIN32)
+DWORD WINAPI random_programs_thread(LPVOID arg) {
+#else
+void* random_programs_thread(void* arg) {
+#endif
+    XCEPTEST_t_RandomJob* job = arg;
+    XCEPTEST_RandomRun(job->seed, job->count, 4, &job->stats);
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// XCEPTEST_RANDOM_PROGRAMS and XCEPTEST_RANDOM_SEED turn it into a soak run, the seed of a failure reproduces it
+int test_random_programs() {
+    const char* count_env = getenv("XCEPTEST_RANDOM_PROGRAMS");
+    const char* seed_env = getenv("XCEPTEST_RANDOM_SEED");
+    const long count = count_env ? atol(count_env) : 20000;
+    const unsigned long long seed = seed_env ? strtoull(seed_env, NULL, 10) : 1;
+
+    XCEPTEST_t_RandomStats stats = { 0 };
+    const clock_t start = clock();
+    XCEPTEST_RandomRun(seed, count, 4, &stats);
+    const double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("   %ld programs, %ld events, %ld throws, %ld mismatches, %.0f programs/s\n", stats.programs, stats.events,
+        stats.throws, stats.mismatches, elapsed > 0 ? (double)stats.programs / elapsed : 0.0);
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    // Same programs on several threads at once, each one only sees its own frames
+    XCEPTEST_t_RandomJob jobs[XCEPTEST_RANDOM_THREADS];
+    XCEPTEST_t_Thread threads[XCEPTEST_RANDOM_THREADS];
+    for (int i = 0; i < XCEPTEST_RANDOM_THREADS; ++i) {
+        jobs[i] = (XCEPTEST_t_RandomJob){ .seed = seed + (unsigned long long)i * (unsigned long long)count, .count = count / XCEPTEST_RANDOM_THREADS };
+        XCEPTEST_ThreadCreate(&threads[i], random_programs_thread, &jobs[i]);
+    }
+    for (int i = 0; i < XCEPTEST_RANDOM_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+        stats.mismatches += jobs[i].stats.mismatches;
+    }
+#endif
+
+    return stats.programs == count && stats.mismatches == 0;
+}
+
+// =======================================================
+// MARK: Test case 32: Handler registry, subscribers, per-code handlers and chaining
+// =======================================================
+
+#include <setjmp.h>
+
+#define XCEPTEST_REGISTRY_THREADS 4
+#define XCEPTEST_REGISTRY_ROUNDS 500
+
+// Slot 0 for the main thread, 1 + i for thread i. Handlers in charge leave with longjmp, as strict throw requires.
+static jmp_buf XCEPTEST_g_registry_escape[XCEPTEST_REGISTRY_THREADS + 1];
+static volatile int XCEPTEST_g_registry_code_calls[XCEPTEST_REGISTRY_THREADS + 1];
+static volatile int XCEPTEST_g_registry_subscriber_calls[2];
+static volatile int XCEPTEST_g_registry_global_calls = 0;
+static volatile int XCEPTEST_g_registry_chained_calls = 0;
+static XCEP_t_ExceptionHandler XCEPTEST_g_registry_chained_previous = NULL;
+
+static int registry_slot(const XCEP_t_Int code) {
+    return code >= XCEPTEST_ERR_REGISTRY_THREAD ? 1 + code - XCEPTEST_ERR_REGISTRY_THREAD : 0;
+}
+
+void registry_subscriber_a(const XCEP_t_Exception* ex) { (void)ex; XCEPTEST_g_registry_subscriber_calls[0]++; }
+void registry_subscriber_b(const XCEP_t_Exception* ex) { (void)ex; XCEPTEST_g_registry_subscriber_calls[1]++; }
+void registry_subscriber_noop(const XCEP_t_Exception* ex) { (void)ex; }
+
+void registry_code_handler(const XCEP_t_Exception* ex) {
+    const int slot = registry_slot(ex->code);
+    XCEPTEST_g_registry_code_calls[slot]++;
+    longjmp(XCEPTEST_g_registry_escape[slot], 1);
+}
+
+void registry_global_handler(const XCEP_t_Exception* ex) {
+    XCEPTEST_g_registry_global_calls++;
+    longjmp(XCEPTEST_g_registry_escape[registry_slot(ex->code)], 1);
+}
+
+void registry_chained_handler(const XCEP_t_Exception* ex) {
+    XCEPTEST_g_registry_chained_calls++;
+    XCEPTEST_g_registry_chained_previous(ex);
+}
+
+// Returns 1 when a handler took the exception away
+XCEPTEST_NOINLINE int registry_throw_uncaught(const int slot, const XCEP_t_Int code) {
+    if (setjmp(XCEPTEST_g_registry_escape[slot]) == 0) {
+        Throw(code, "uncaught on purpose");
+        return 0;
+    }
+    return 1;
+}
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+#if defined(_WIN32)
+DWORD WINAPI registry_thread(LPVOID arg) {
+#else
+void* registry_thread(void* arg) {
+#endif
+    const int index = (int)(size_t)arg;
+    const XCEP_t_Int code = XCEPTEST_ERR_REGISTRY_THREAD + index;
+    for (int round = 0; round < XCEPTEST_REGISTRY_ROUNDS; ++round) {
+        // Subscriptions come and go while the other threads dispatch
+        AddUncaughtExceptionHandler(registry_subscriber_noop);
+        if (SetCodeUncaughtExceptionHandler(code, registry_code_handler, NULL) == 0
+                && XCEP_GetCodeUncaughtExceptionHandler(code) == registry_code_handler) {
+            registry_throw_uncaught(1 + index, code);
+        }
+        SetCodeUncaughtExceptionHandler(code, NULL, NULL);
+        RemoveUncaughtExceptionHandler(registry_subscriber_noop);
+    }
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+#endif
+
+int test_handler_registry() {
+    XCEP_t_ExceptionHandler previous = NULL;
+    const XCEP_t_ExceptionHandler original_handler = SetUncaughtExceptionHandler(registry_global_handler);
+
+    const int subscribed_ok = AddUncaughtExceptionHandler(registry_subscriber_a) == 0 && AddUncaughtExceptionHandler(registry_subscriber_b) == 0;
+    const int set_ok = SetCodeUncaughtExceptionHandler(XCEPTEST_ERR_REGISTRY, registry_code_handler, &previous) == 0 && previous == NULL;
+
+    // The code handler takes precedence over the global one, subscribers see both
+    registry_throw_uncaught(0, XCEPTEST_ERR_REGISTRY);
+    registry_throw_uncaught(0, XCEPTEST_ERR_REGISTRY_OTHER);
+    const int dispatch_ok = XCEPTEST_g_registry_code_calls[0] == 1 && XCEPTEST_g_registry_global_calls == 1
+        && XCEPTEST_g_registry_subscriber_calls[0] == 2 && XCEPTEST_g_registry_subscriber_calls[1] == 2;
+
+    // Chaining to the handler replaced
+    XCEPTEST_g_registry_chained_previous = SetUncaughtExceptionHandler(registry_chained_handler);
+    registry_throw_uncaught(0, XCEPTEST_ERR_REGISTRY_OTHER);
+    const int chained_ok = XCEPTEST_g_registry_chained_previous == registry_global_handler
+        && XCEPTEST_g_registry_chained_calls == 1 && XCEPTEST_g_registry_global_calls == 2;
+
+    // Without its code handler the code goes to the global chain, without a subscription the subscriber is skipped
+    SetCodeUncaughtExceptionHandler(XCEPTEST_ERR_REGISTRY, NULL, &previous);
+    const int removed_ok = previous == registry_code_handler && XCEP_GetCodeUncaughtExceptionHandler(XCEPTEST_ERR_REGISTRY) == NULL
+        && RemoveUncaughtExceptionHandler(registry_subscriber_a) && !RemoveUncaughtExceptionHandler(registry_subscriber_a);
+    registry_throw_uncaught(0, XCEPTEST_ERR_REGISTRY);
+    const int fallback_ok = XCEPTEST_g_registry_code_calls[0] == 1 && XCEPTEST_g_registry_global_calls == 3
+        && XCEPTEST_g_registry_subscriber_calls[0] == 3 && XCEPTEST_g_registry_subscriber_calls[1] == 4;
+    RemoveUncaughtExceptionHandler(registry_subscriber_b);
+
+    int threads_ok = 1;
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    XCEPTEST_t_Thread threads[XCEPTEST_REGISTRY_THREADS];
+    for (int i = 0; i < XCEPTEST_REGISTRY_THREADS; ++i) {
+        XCEPTEST_ThreadCreate(&threads[i], registry_thread, (void*)(size_t)i);
+    }
+    for (int i = 0; i < XCEPTEST_REGISTRY_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+        threads_ok = threads_ok && XCEPTEST_g_registry_code_calls[1 + i] == XCEPTEST_REGISTRY_ROUNDS;
+    }
+    printf("   %d threads, %d uncaught exceptions each reached their code handler\n", XCEPTEST_REGISTRY_THREADS, XCEPTEST_REGISTRY_ROUNDS);
+#endif
+
+    SetUncaughtExceptionHandler(original_handler);
+    return subscribed_ok && set_ok && dispatch_ok && chained_ok && removed_ok && fallback_ok && threads_ok;
+}
+
+// =======================================================
+// MARK: Test case 33: Try depth counters, depth limit and process-wide high-water mark
+// =======================================================
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS || XCEP_CONF_TRY_DEPTH_LIMIT
+
+#define XCEPTEST_DEPTH_NESTED 16
+#define XCEPTEST_DEPTH_THREADS 4
+
+// One Try per level, as a recursive descent parser entering a rule. Negative levels never stop.
+XCEPTEST_NOINLINE void depth_recurse(const int levels, const int throw_at_bottom, XCEP_t_TryDepth* innermost) {
+    Try {
+        if (levels != 1) {
+            depth_recurse(levels - 1, throw_at_bottom, innermost);
+        } else {
+            XCEP_GetTryDepth(innermost);
+            if (throw_at_bottom) Throw(XCEPTEST_ERR_TRY_DEPTH, "from the innermost Try");
+        }
+    }
+    EndTry;
+}
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS && XCEP_CONF_ENABLE_THREAD_SAFE
+static XCEP_t_TryDepth XCEPTEST_g_depth_thread[XCEPTEST_DEPTH_THREADS];
+
+#if defined(_WIN32)
+DWORD WINAPI depth_thread(LPVOID arg) {
+#else
+void* depth_thread(void* arg) {
+#endif
+    XCEP_t_TryDepth innermost;
+    depth_recurse(2 * XCEPTEST_DEPTH_NESTED, 0, &innermost);
+    XCEP_GetTryDepth(&XCEPTEST_g_depth_thread[(size_t)arg]);
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+#endif
+
+int test_try_depth() {
+    XCEP_t_TryDepth before, innermost, after;
+    XCEP_GetTryDepth(&before);
+
+    depth_recurse(XCEPTEST_DEPTH_NESTED, 0, &innermost);
+    const int nested_ok = innermost.depth == before.depth + XCEPTEST_DEPTH_NESTED
+        && innermost.frame_bytes == innermost.depth * XCEP_TRY_FRAME_SIZE;
+
+    // A throw leaves every Try it crosses
+    Try {
+        depth_recurse(XCEPTEST_DEPTH_NESTED, 1, &innermost);
+    }
+    Catch(XCEPTEST_ERR_TRY_DEPTH) {
+    }
+    EndTry;
+    XCEP_GetTryDepth(&after);
+    const int unwound_ok = innermost.depth == before.depth + XCEPTEST_DEPTH_NESTED + 1 && after.depth == before.depth
+        && after.max_depth >= innermost.depth && after.max_frame_bytes == after.max_depth * XCEP_TRY_FRAME_SIZE;
+    printf("   %u nested Try use %u bytes of frames\n", innermost.depth, (unsigned)innermost.frame_bytes);
+
+    int limit_ok = 1;
+#if XCEP_CONF_TRY_DEPTH_LIMIT
+    // Unbounded recursion fails with XCEP_ERR_TRY_DEPTH at the limit instead of overflowing the stack
+    volatile int limit_caught = 0;
+    Try {
+        depth_recurse(-1, 0, &innermost);
+    }
+    Catch(XCEP_ERR_TRY_DEPTH) {
+        limit_caught = 1;
+        PrintException("Depth limit", &CaughtException);
+    }
+    EndTry;
+    XCEP_GetTryDepth(&after);
+    limit_ok = limit_caught && after.depth == before.depth && after.max_depth == XCEP_CONF_TRY_DEPTH_LIMIT;
+#endif
+
+    int stats_ok = 1;
+#if XCEP_CONF_ENABLE_DEPTH_STATS
+    XCEP_t_TryDepthStats stats;
+    XCEP_TryDepthSnapshot(&stats);
+    stats_ok = stats.max_depth >= after.max_depth && stats.max_frame_bytes == stats.max_depth * XCEP_TRY_FRAME_SIZE && stats.contexts >= 1;
+#if XCEP_CONF_TRY_DEPTH_LIMIT
+    stats_ok = stats_ok && stats.limit_hits >= 1;
+#endif
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    // Every new thread is a new context with its own counters
+    XCEPTEST_t_Thread threads[XCEPTEST_DEPTH_THREADS];
+    for (int i = 0; i < XCEPTEST_DEPTH_THREADS; ++i) {
+        XCEPTEST_ThreadCreate(&threads[i], depth_thread, (void*)(size_t)i);
+    }
+    for (int i = 0; i < XCEPTEST_DEPTH_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+        stats_ok = stats_ok && XCEPTEST_g_depth_thread[i].depth == 0 && XCEPTEST_g_depth_thread[i].max_depth == 2 * XCEPTEST_DEPTH_NESTED;
+    }
+    XCEP_t_TryDepthStats threads_stats;
+    XCEP_TryDepthSnapshot(&threads_stats);
+    stats_ok = stats_ok && threads_stats.contexts == stats.contexts + XCEPTEST_DEPTH_THREADS
+        && threads_stats.max_depth >= 2 * XCEPTEST_DEPTH_NESTED;
+#endif
+    printf("   process: max depth %u (%u bytes), %lld contexts, %lld limit hits\n",
+        stats.max_depth, (unsigned)stats.max_frame_bytes, stats.contexts, stats.limit_hits);
+#endif
+
+    return nested_ok && unwound_ok && limit_ok && stats_ok;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 34: Throw-to-catch latency and hop histograms per code
+// =======================================================
+
+#if XCEP_CONF_ENABLE_LATENCY
+
+#define XCEPTEST_LATENCY_SHALLOW 100
+#define XCEPTEST_LATENCY_DEEP 50
+#define XCEPTEST_LATENCY_LEVELS 7
+#define XCEPTEST_LATENCY_THREADS 4
+#define XCEPTEST_LATENCY_THREAD_THROWS 1000
+
+// Throws through `levels` Try without a Catch, each of them is one more hop
+XCEPTEST_NOINLINE void latency_nest(const int levels, const XCEP_t_Int code) {
+    if (levels == 0) Throw(code, "timed");
+    Try {
+        latency_nest(levels - 1, code);
+    }
+    EndTry;
+}
+
+XCEPTEST_NOINLINE void latency_catch(const int levels, const XCEP_t_Int code) {
+    Try {
+        latency_nest(levels, code);
+    }
+    CatchAll {
+    }
+    EndTry;
+}
+
+static int latency_find(const XCEP_t_Int code, XCEP_t_LatencyHistogram* out) {
+    XCEP_t_LatencyHistogram histograms[XCEP_CONF_LATENCY_CODES + 1];
+    const size_t count = XCEP_LatencySnapshot(histograms, XCEP_CONF_LATENCY_CODES + 1);
+    for (size_t i = 0; i < count && i <= XCEP_CONF_LATENCY_CODES; ++i) {
+        if (!histograms[i].overflow && histograms[i].code == code) {
+            *out = histograms[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static long long latency_sum(const long long* buckets, const int count) {
+    long long sum = 0;
+    for (int i = 0; i < count; ++i) sum += buckets[i];
+    return sum;
+}
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+#if defined(_WIN32)
+DWORD WINAPI latency_thread(LPVOID arg) {
+#else
+void* latency_thread(void* arg) {
+#endif
+    (void)arg;
+    for (int i = 0; i < XCEPTEST_LATENCY_THREAD_THROWS; ++i) {
+        latency_catch(1, XCEPTEST_ERR_LATENCY_THREAD);
+    }
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+#endif
+
+int test_latency() {
+    for (int i = 0; i < XCEPTEST_LATENCY_SHALLOW; ++i) latency_catch(0, XCEPTEST_ERR_LATENCY);
+    for (int i = 0; i < XCEPTEST_LATENCY_DEEP; ++i) latency_catch(XCEPTEST_LATENCY_LEVELS, XCEPTEST_ERR_LATENCY_DEEP);
+
+    // Caught twice: the Rethrow starts a new dispatch, one hop to the enclosing Try
+    Try {
+        Try {
+            Throw(XCEPTEST_ERR_LATENCY_RETHROW, "rethrown");
+        }
+        Catch(XCEPTEST_ERR_LATENCY_RETHROW) {
+            Rethrow;
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_LATENCY_RETHROW) {
+    }
+    EndTry;
+
+    XCEP_t_LatencyHistogram shallow, deep, rethrown;
+    const int found_ok = latency_find(XCEPTEST_ERR_LATENCY, &shallow) && latency_find(XCEPTEST_ERR_LATENCY_DEEP, &deep)
+        && latency_find(XCEPTEST_ERR_LATENCY_RETHROW, &rethrown);
+    if (!found_ok) return 0;
+
+    const int counts_ok = shallow.count == XCEPTEST_LATENCY_SHALLOW && deep.count == XCEPTEST_LATENCY_DEEP && rethrown.count == 2
+        && latency_sum(shallow.latency, XCEP_LATENCY_BUCKETS) == shallow.count && latency_sum(deep.hops, XCEP_HOPS_BUCKETS) == deep.count;
+    const int hops_ok = XCEP_LatencyPercentile(shallow.hops, XCEP_HOPS_BUCKETS, 1.0) == 1
+        && XCEP_LatencyPercentile(deep.hops, XCEP_HOPS_BUCKETS, 0.5) == XCEPTEST_LATENCY_LEVELS + 1
+        && XCEP_LatencyPercentile(rethrown.hops, XCEP_HOPS_BUCKETS, 1.0) == 1;
+
+    // Log-linear buckets: exact below 8, then 4 per power of two
+    const int buckets_ok = XCEP_LatencyBucketLow(7) == 7 && XCEP_LatencyBucketLow(8) == 8 && XCEP_LatencyBucketLow(9) == 10
+        && XCEP_LatencyBucketLow(12) == 16 && XCEP_LatencyBucketLow(XCEP_HOPS_BUCKETS - 1) == 7ull << 9;
+
+    XCEP_t_LatencyHistogram merged = shallow;
+    XCEP_LatencyMerge(&merged, &deep);
+    const int merge_ok = merged.count == XCEPTEST_LATENCY_SHALLOW + XCEPTEST_LATENCY_DEEP
+        && XCEP_LatencyPercentile(merged.hops, XCEP_HOPS_BUCKETS, 0.5) == 1
+        && XCEP_LatencyPercentile(merged.hops, XCEP_HOPS_BUCKETS, 1.0) == XCEPTEST_LATENCY_LEVELS + 1;
+
+    int threads_ok = 1;
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    // The counts are shared with the other tests catching the same code
+    XCEP_t_LatencyHistogram threaded;
+    const long long threaded_before = latency_find(XCEPTEST_ERR_LATENCY_THREAD, &threaded) ? threaded.count : 0;
+    XCEPTEST_t_Thread threads[XCEPTEST_LATENCY_THREADS];
+    for (int i = 0; i < XCEPTEST_LATENCY_THREADS; ++i) {
+        XCEPTEST_ThreadCreate(&threads[i], latency_thread, NULL);
+    }
+    for (int i = 0; i < XCEPTEST_LATENCY_THREADS; ++i) {
+        XCEPTEST_ThreadJoin(threads[i]);
+    }
+    threads_ok = latency_find(XCEPTEST_ERR_LATENCY_THREAD, &threaded)
+        && threaded.count - threaded_before == XCEPTEST_LATENCY_THREADS * XCEPTEST_LATENCY_THREAD_THROWS
+        && XCEP_LatencyPercentile(threaded.hops, XCEP_HOPS_BUCKETS, 1.0) == 2;
+#endif
+
+    // One line per code, the deep one shows its hops
+    int dump_ok = 0;
+    FILE* dump = tmpfile();
+    if (dump != NULL) {
+        char line[256];
+        XCEP_LatencyDump(dump);
+        rewind(dump);
+        while (fgets(line, sizeof(line), dump) != NULL) {
+            if (strncmp(line, "141 ", 4) == 0) {
+                dump_ok = 1;
+                printf("   %lld ticks/s\n   %s", XCEP_LatencyTickRate(), line);
+            }
+        }
+        fclose(dump);
+    }
+
+    return counts_ok && hops_ok && buckets_ok && merge_ok && threads_ok && dump_ok;
+}
+
+#endif
+
+// =======================================================
+// MARK: Test case 35: Two-phase search, TryFilter frames passed over in one jump and CatchWhen
+// =======================================================
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+
+#define XCEPTEST_FILTER_LEVELS 6
+
+static volatile int XCEPTEST_g_filter_calls = 0;
+static volatile int XCEPTEST_g_filter_catch_calls = 0;
+static volatile int XCEPTEST_g_filter_cleanups = 0;
+static volatile int XCEPTEST_g_filter_unwound_early = 0;
+
+static XCEP_t_Bool filter_refuse(const XCEP_t_Exception* exception) {
+    (void)exception;
+    XCEPTEST_g_filter_calls++;
+    // The first phase runs before any cleanup of the frames it looks at
+    if (XCEPTEST_g_filter_cleanups != 0) XCEPTEST_g_filter_unwound_early = 1;
+    return XCEP_FALSE;
+}
+
+static XCEP_t_Bool catch_refuse(const XCEP_t_Exception* exception) {
+    (void)exception;
+    XCEPTEST_g_filter_catch_calls++;
+    return XCEP_FALSE;
+}
+
+static XCEP_t_Bool filter_even_code(const XCEP_t_Exception* exception) {
+    return (exception->code & 1) == 0;
+}
+
+#if XCEP_CONF_ENABLE_DEFER
+static void filter_cleanup(void* arg) {
+    (void)arg;
+    XCEPTEST_g_filter_cleanups++;
+}
+#endif
+
+// Every level refuses the exception: its filter is asked once, its Catch clauses never run
+XCEPTEST_NOINLINE void filter_levels(const int levels, const XCEP_t_Int code) {
+    if (levels == 0) Throw(code, "through the filters");
+    TryFilter(FilterWhen(filter_refuse)) {
+    #if XCEP_CONF_ENABLE_DEFER
+        Defer(filter_cleanup, NULL);
+    #endif
+        filter_levels(levels - 1, code);
+    #if XCEP_CONF_ENABLE_DEFER
+        DeferRelease();
+    #endif
+    }
+    CatchWhen(catch_refuse) {
+    }
+    EndTry;
+}
+
+// A filter taking the exception, caught then rethrown past filters refusing it
+XCEPTEST_NOINLINE void filter_rethrow(void) {
+    TryFilter(FilterCodes(XCEPTEST_ERR_FILTER_OTHER, XCEPTEST_ERR_FILTERED)) {
+        Throw(XCEPTEST_ERR_FILTERED, "caught then rethrown");
+    }
+    CatchAny(XCEPTEST_ERR_FILTER_OTHER, XCEPTEST_ERR_FILTERED) {
+        Rethrow;
+    }
+    EndTry;
+}
+
+int test_two_phase() {
+    volatile int outer_caught = 0;
+#if XCEP___TRACK_DEPTH
+    XCEP_t_TryDepth depth_before, depth_after;
+    XCEP_GetTryDepth(&depth_before);
+#endif
+
+    Try {
+        filter_levels(XCEPTEST_FILTER_LEVELS, XCEPTEST_ERR_FILTERED);
+    }
+    Catch(XCEPTEST_ERR_FILTERED) {
+        outer_caught = 1;
+    }
+    EndTry;
+    volatile int skipped_ok = outer_caught && XCEPTEST_g_filter_calls == XCEPTEST_FILTER_LEVELS
+        && XCEPTEST_g_filter_catch_calls == 0 && !XCEPTEST_g_filter_unwound_early;
+#if XCEP_CONF_ENABLE_DEFER
+    const int cleanups_ok = XCEPTEST_g_filter_cleanups == XCEPTEST_FILTER_LEVELS;
+#else
+    const int cleanups_ok = 1;
+#endif
+
+    // The Rethrow searches as well
+    volatile int rethrown_caught = 0;
+    XCEPTEST_g_filter_calls = 0;
+    Try {
+        TryFilter(FilterWhen(filter_refuse)) {
+            TryFilter(FilterRange(XCEPTEST_ERR_FILTER_WHEN, XCEPTEST_ERR_FILTER_WHEN)) {
+                filter_rethrow();
+            }
+            Catch(XCEPTEST_ERR_FILTER_WHEN) {
+            }
+            EndTry;
+        }
+        CatchWhen(catch_refuse) {
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_FILTERED) {
+        rethrown_caught = 1;
+    }
+    EndTry;
+    volatile int rethrow_ok = rethrown_caught && XCEPTEST_g_filter_calls == 1 && XCEPTEST_g_filter_catch_calls == 0;
+
+    // A filter accepting the exception lands, CatchWhen also works in a plain Try
+    volatile int when_caught = 0;
+    volatile int plain_when_caught = 0;
+    TryFilter(FilterWhen(filter_even_code)) {
+        Throw(XCEPTEST_ERR_FILTER_WHEN, "even code");
+    }
+    CatchWhen(filter_even_code) {
+        when_caught = CaughtException.code == XCEPTEST_ERR_FILTER_WHEN;
+    }
+    EndTry;
+    Try {
+        Throw(XCEPTEST_ERR_FILTER_OTHER, "odd code");
+    }
+    CatchWhen(filter_even_code) {
+    }
+    CatchWhen(catch_refuse) {
+    }
+    CatchAll {
+        plain_when_caught = CaughtException.code == XCEPTEST_ERR_FILTER_OTHER && XCEPTEST_g_filter_catch_calls == 1;
+    }
+    EndTry;
+
+    int depth_ok = 1;
+#if XCEP___TRACK_DEPTH
+    XCEP_GetTryDepth(&depth_after);
+    depth_ok = depth_after.depth == depth_before.depth;
+#endif
+
+    return skipped_ok && cleanups_ok && rethrow_ok && when_caught && plain_when_caught && depth_ok;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 36: Cause chains, ThrowWithCause in a Catch and the bounded per-thread ring
+// =======================================================
+
+#if XCEP_CONF_CAUSE_DEPTH
+
+// Each level catches the exception of the level below and throws its own, caused by it
+XCEPTEST_NOINLINE void cause_levels(const int levels) {
+    if (levels == 0) Throw(XCEPTEST_ERR_CAUSE_ROOT, "root cause");
+    Try {
+        cause_levels(levels - 1);
+    }
+    CatchAll {
+        ThrowWithCause(XCEPTEST_ERR_CAUSE_LEVEL_BASE + levels, "wrapped");
+    }
+    EndTry;
+}
+
+int test_cause_chain() {
+    XCEP_t_CauseIterator iterator;
+    const XCEP_t_Exception* cause;
+
+    volatile int direct_ok = 0;
+    Try {
+        cause_levels(1);
+    }
+    Catch(XCEPTEST_ERR_CAUSE_LEVEL_BASE + 1) {
+        XCEP_CauseBegin(&iterator);
+        cause = XCEP_CauseNext(&iterator);
+        direct_ok = XCEP_CauseCount() == 1 && cause != NULL && cause->code == XCEPTEST_ERR_CAUSE_ROOT
+            && strcmp(cause->message, "root cause") == 0 && XCEP_CauseNext(&iterator) == NULL;
+    }
+    EndTry;
+
+    // A longer chain keeps its newest causes, the direct one first
+    const int levels = XCEP_CONF_CAUSE_DEPTH < 8 ? XCEP_CONF_CAUSE_DEPTH + 2 : 9;
+    volatile int bounded_ok = 0;
+    Try {
+        cause_levels(levels);
+    }
+    CatchAll {
+        PrintException("Caught with its causes", &CaughtException);
+        int expected = XCEPTEST_ERR_CAUSE_LEVEL_BASE + levels - 1;
+        int count = 0;
+        XCEP_CauseBegin(&iterator);
+        bounded_ok = 1;
+        while ((cause = XCEP_CauseNext(&iterator)) != NULL) {
+            const int code = expected > XCEPTEST_ERR_CAUSE_LEVEL_BASE ? expected : XCEPTEST_ERR_CAUSE_ROOT;
+            if (cause->code != code) bounded_ok = 0;
+            expected--;
+            count++;
+        }
+        const int kept = levels < XCEP_CONF_CAUSE_DEPTH ? levels : XCEP_CONF_CAUSE_DEPTH;
+        bounded_ok = bounded_ok && count == kept && XCEP_CauseCount() == (XCEP_t_Uint)kept;
+    }
+    EndTry;
+
+    // Rethrow keeps the chain, a plain throw and a ThrowWithCause outside a Catch have none
+    volatile int rethrow_ok = 0;
+    volatile int plain_ok = 0;
+    volatile int outside_ok = 0;
+    Try {
+        Try {
+            cause_levels(1);
+        }
+        CatchAll {
+            Rethrow;
+        }
+        EndTry;
+    }
+    CatchAll {
+        rethrow_ok = XCEP_CauseCount() == 1;
+    }
+    EndTry;
+    Try {
+        Throw(XCEPTEST_ERR_CAUSE_PLAIN, "no cause");
+    }
+    CatchAll {
+        plain_ok = XCEP_CauseCount() == 0;
+    }
+    EndTry;
+    Try {
+        ThrowWithCause(XCEPTEST_ERR_CAUSE_PLAIN, "nothing handled");
+    }
+    CatchAll {
+        outside_ok = XCEP_CauseCount() == 0;
+    }
+    EndTry;
+
+    // From a Try nested in the Catch, the handled exception still is the cause
+    volatile int nested_ok = 0;
+    Try {
+        Throw(XCEPTEST_ERR_CAUSE_ROOT, "handled outside");
+    }
+    CatchAll {
+        Try {
+            ThrowWithCause(XCEPTEST_ERR_CAUSE_PLAIN, "thrown in a nested Try");
+        }
+        CatchAll {
+            XCEP_CauseBegin(&iterator);
+            cause = XCEP_CauseNext(&iterator);
+            nested_ok = cause != NULL && cause->code == XCEPTEST_ERR_CAUSE_ROOT;
+        }
+        EndTry;
+    }
+    EndTry;
+
+    // Exceptions thrown and caught in the Catch first, with chains of their own: the cause still is the one
+    // handled, followed by its chain. Rethrow sends it with that chain too.
+    volatile int replaced_ok = 0;
+    volatile int replaced_rethrow_ok = 0;
+    Try {
+        Try {
+            cause_levels(2);
+        }
+        CatchAll {
+            Try {
+                Throw(XCEPTEST_ERR_CAUSE_PLAIN, "caught in the Catch");
+            }
+            CatchAll {
+            }
+            EndTry;
+            Try {
+                cause_levels(2);
+            }
+            CatchAll {
+            }
+            EndTry;
+            ThrowWithCause(XCEPTEST_ERR_CAUSE_PLAIN, "caused by the handled one");
+        }
+        EndTry;
+    }
+    CatchAll {
+        XCEP_CauseBegin(&iterator);
+        cause = XCEP_CauseNext(&iterator);
+        replaced_ok = cause != NULL && cause->code == XCEPTEST_ERR_CAUSE_LEVEL_BASE + 2 && strcmp(cause->message, "wrapped") == 0;
+        cause = XCEP_CauseNext(&iterator);
+        replaced_ok = replaced_ok && cause != NULL && cause->code == XCEPTEST_ERR_CAUSE_LEVEL_BASE + 1;
+    }
+    EndTry;
+    Try {
+        Try {
+            cause_levels(1);
+        }
+        CatchAll {
+            Try {
+                cause_levels(2);
+            }
+            CatchAll {
+            }
+            EndTry;
+            Rethrow;
+        }
+        EndTry;
+    }
+    CatchAll {
+        XCEP_CauseBegin(&iterator);
+        cause = XCEP_CauseNext(&iterator);
+        replaced_rethrow_ok = CaughtException.code == XCEPTEST_ERR_CAUSE_LEVEL_BASE + 1 && XCEP_CauseCount() == 1
+            && cause != NULL && cause->code == XCEPTEST_ERR_CAUSE_ROOT;
+    }
+    EndTry;
+
+    // The cause keeps a copy of its message, a formatted one outlives its arena slot
+    volatile int copy_ok = 1;
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+    copy_ok = 0;
+    Try {
+        Try {
+            ThrowF(XCEPTEST_ERR_CAUSE_ROOT, "formatted %d", 36);
+        }
+        CatchAll {
+            ThrowWithCause(XCEPTEST_ERR_CAUSE_PLAIN, "wrapping a formatted message");
+        }
+        EndTry;
+    }
+    CatchAll {
+        for (int i = 0; i < 64; ++i) {
+            (void)XCEP_FormatMessage("overwrite %d", i);
+        }
+        XCEP_CauseBegin(&iterator);
+        cause = XCEP_CauseNext(&iterator);
+        copy_ok = cause != NULL && strcmp(cause->message, "formatted 36") == 0;
+    }
+    EndTry;
+#endif
+
+    return direct_ok && bounded_ok && rethrow_ok && plain_ok && outside_ok && nested_ok && replaced_ok && replaced_rethrow_ok
+        && copy_ok;
+}
+
+#endif
+// =======================================================
+// MARK: Test case 37: Flight recorder, per-thread regions of the mapped file read back after close
+// =======================================================
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+
+#define XCEPTEST_RECORDER_PATH "XCEPTEST_recorder.bin"
+#define XCEPTEST_RECORDER_THREADS 2
+#define XCEPTEST_RECORDER_THREAD_THROWS (XCEP_CONF_RECORDER_EVENTS + 10)
+
+static void* recorder_thread_worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < XCEPTEST_RECORDER_THREAD_THROWS; ++i) {
+        Try {
+            Throw(XCEPTEST_ERR_RECORDER_THREAD, "from a recorded thread");
+        }
+        Catch(XCEPTEST_ERR_RECORDER_THREAD) {
+        }
+        EndTry;
+    }
+    return NULL;
+}
+
+int test_flight_recorder() {
+    if (XCEP_RecorderOpen(XCEPTEST_RECORDER_PATH) != 0) {
+        fprintf(stderr, "   Cannot open %s\n", XCEPTEST_RECORDER_PATH);
+        return 0;
+    }
+
+    // Caught, then rethrown and caught again: throw, catch, throw, catch, rethrow, catch
+    Try {
+        Throw(XCEPTEST_ERR_RECORDER, "recorded");
+    }
+    Catch(XCEPTEST_ERR_RECORDER) {
+    }
+    EndTry;
+    Try {
+        Try {
+            Throw(XCEPTEST_ERR_RECORDER, "recorded then rethrown");
+        }
+        CatchAll {
+            Rethrow;
+        }
+        EndTry;
+    }
+    Catch(XCEPTEST_ERR_RECORDER) {
+    }
+    EndTry;
+
+    volatile int threads = 0;
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    XCEPTEST_t_Thread workers[XCEPTEST_RECORDER_THREADS];
+    for (; threads < XCEPTEST_RECORDER_THREADS; ++threads) {
+        if (XCEPTEST_ThreadCreate(&workers[threads], recorder_thread_worker, NULL) != 0) break;
+    }
+    for (int i = 0; i < threads; ++i) {
+        XCEPTEST_ThreadJoin(workers[i]);
+    }
+#endif
+    XCEP_RecorderClose();
+
+    // Nothing is recorded once closed
+    Try {
+        Throw(XCEPTEST_ERR_RECORDER, "not recorded");
+    }
+    CatchAll {
+    }
+    EndTry;
+
+    FILE* file = fopen(XCEPTEST_RECORDER_PATH, "rb");
+    if (file == NULL) return 0;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = malloc((size_t)size);
+    const int read_ok = data != NULL && fread(data, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    remove(XCEPTEST_RECORDER_PATH);
+    if (!read_ok) {
+        free(data);
+        return 0;
+    }
+
+    const XCEP_t_RecorderHeader* header = (const XCEP_t_RecorderHeader*)data;
+    const int header_ok = memcmp(header->magic, XCEP_RECORDER_MAGIC, sizeof(header->magic)) == 0
+        && header->version == XCEP_RECORDER_VERSION && header->region_events == XCEP_CONF_RECORDER_EVENTS
+        && header->regions_claimed == 1 + threads
+        && (size_t)size >= header->header_size + (size_t)header->region_count * header->region_size;
+
+    // The calling thread claimed the first region with its first throw
+    static const unsigned int expected_kinds[] = {
+        XCEP_RECORD_THROW, XCEP_RECORD_CATCH, XCEP_RECORD_THROW, XCEP_RECORD_CATCH, XCEP_RECORD_RETHROW, XCEP_RECORD_CATCH
+    };
+    const XCEP_t_RecorderRegion* region = (const XCEP_t_RecorderRegion*)(data + header->header_size);
+    const XCEP_t_RecorderEvent* events = (const XCEP_t_RecorderEvent*)(region + 1);
+    int main_ok = header_ok && region->head == 6;
+    for (int i = 0; main_ok && i < 6; ++i) {
+        main_ok = events[i].kind == expected_kinds[i] && events[i].code == XCEPTEST_ERR_RECORDER
+            && events[i].time_ns >= header->start_monotonic_ns && (i == 0 || events[i].time_ns >= events[i - 1].time_ns);
+    }
+    main_ok = main_ok && strcmp(events[0].message, "recorded") == 0 && strncmp(events[2].message, "recorded then", 13) == 0;
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+    main_ok = main_ok && strncmp(events[0].function, "test_flight_recorder", sizeof(events[0].function) - 1) == 0 && events[0].line != 0;
+#endif
+
+    // Every thread region kept the newest events of its ring, the oldest were overwritten
+    int threads_ok = header_ok;
+    for (int r = 1; threads_ok && r <= threads; ++r) {
+        region = (const XCEP_t_RecorderRegion*)(data + header->header_size + (size_t)r * header->region_size);
+        events = (const XCEP_t_RecorderEvent*)(region + 1);
+        const unsigned long long last = region->head - 1;
+        threads_ok = region->head == 2 * XCEPTEST_RECORDER_THREAD_THROWS
+            && events[last & (XCEP_CONF_RECORDER_EVENTS - 1)].kind == XCEP_RECORD_CATCH
+            && events[(last - 1) & (XCEP_CONF_RECORDER_EVENTS - 1)].kind == XCEP_RECORD_THROW
+            && events[last & (XCEP_CONF_RECORDER_EVENTS - 1)].code == XCEPTEST_ERR_RECORDER_THREAD;
+    }
+
+    free(data);
+    return main_ok && threads_ok;
+}
+
+#endif
+
+int XCEPTEST_RunTest() {
+
+    printf("===== XCEP Test Suite =====\n\n");
+
+    printf("    XCEP_CONF_ENABLE_THREAD_SAFE=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_THREAD_SAFE) "\n");
+    printf("    XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO) "\n");
+    printf("    XCEP_CONF_ENABLE_CUSTOM_TYPES=" XCEPTEST_BOOL2STR(XCEP_CONF_ENABLE_CUSTOM_TYPES) "\n");
+    printf("    XCEP_CONF_JUMP_BACKEND=%d (sizeof(XCEP_t_Frame)=%u)\n", XCEP___JUMP_BACKEND, (unsigned)sizeof(XCEP_t_Frame));
+
+    puts("");
+
+    printf("====== Running Test =======\n\n");
+
+    XCEPTEST_RUN_TEST(test_no_throw);
+    XCEPTEST_RUN_TEST(test_simple_catch);
+    XCEPTEST_RUN_TEST(test_catch_all);
+    XCEPTEST_RUN_TEST(test_nested_handled_exception);
+    XCEPTEST_RUN_TEST(test_rethrow);
+    XCEPTEST_RUN_TEST(test_throw_from_catch);
+    XCEPTEST_RUN_TEST(test_nested_uncaught_propagation);
+    XCEPTEST_RUN_TEST(test_nested_rethrow);
+    XCEPTEST_RUN_TEST(test_resource_cleanup_with_finally);
+    XCEPTEST_RUN_TEST(test_volatile_variable_correctness);
+    XCEPTEST_RUN_TEST(test_multiple_catch_blocks);
+    XCEPTEST_RUN_TEST(test_try_finally_only);
+#if !XCEP_CONF_STRICT_THROW
+    XCEPTEST_RUN_TEST(test_uncaught_exception);
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    XCEPTEST_RUN_TEST(test_thread_safety_scalable);
+#else
+    printf("===== Warnings =====\n");
+    printf("   Thread safety tests are disabled.\n");
+#endif
+
+    XCEPTEST_RUN_TEST(test_cached_context);
+#if XCEP_CONF_ENABLE_DEFER
+    XCEPTEST_RUN_TEST(test_defer);
+    XCEPTEST_RUN_TEST(test_defer_overflow);
+#endif
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+    XCEPTEST_RUN_TEST(test_catch_type);
+#endif
+    XCEPTEST_RUN_TEST(test_catch_any_range);
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+    XCEPTEST_RUN_TEST(test_throw_formatted);
+#endif
+#if XCEP_CONF_PAYLOAD_SIZE
+    XCEPTEST_RUN_TEST(test_throw_with_payload);
+#endif
+#if XCEP_CONF_BACKTRACE_DEPTH
+    XCEPTEST_RUN_TEST(test_backtrace_sampling);
+#endif
+#if XCEP_CONF_ENABLE_STATS
+    XCEPTEST_RUN_TEST(test_throw_site_stats);
+#endif
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+    XCEPTEST_RUN_TEST(test_async_log);
+#endif
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+    XCEPTEST_RUN_TEST(test_exception_ptr);
+#endif
+#if XCEP_CONF_ENABLE_THREAD_API
+    XCEPTEST_RUN_TEST(test_thread_join_rethrow);
+    XCEPTEST_RUN_TEST(test_task_group);
+#endif
+#if XCEP_CONF_ENABLE_SIGNALS
+    XCEPTEST_RUN_TEST(test_signal_exceptions);
+#endif
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH && XCEP_CONF_ENABLE_THREAD_SAFE && !defined(_WIN32)
+    XCEPTEST_RUN_TEST(test_fiber_context_switch);
+#endif
+    XCEPTEST_RUN_TEST(test_result_escalation);
+#if XCEP_CONF_STRICT_THROW
+    XCEPTEST_RUN_TEST(test_strict_uncaught_handler);
+#endif
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+    XCEPTEST_RUN_TEST(test_compact_sites);
+#endif
+    XCEPTEST_RUN_TEST(test_random_programs);
+    XCEPTEST_RUN_TEST(test_handler_registry);
+#if XCEP_CONF_ENABLE_DEPTH_STATS || XCEP_CONF_TRY_DEPTH_LIMIT
+    XCEPTEST_RUN_TEST(test_try_depth);
+#endif
+#if XCEP_CONF_ENABLE_LATENCY
+    XCEPTEST_RUN_TEST(test_latency);
+#endif
+#if XCEP_CONF_ENABLE_TWO_PHASE
+    XCEPTEST_RUN_TEST(test_two_phase);
+#endif
+#if XCEP_CONF_CAUSE_DEPTH
+    XCEPTEST_RUN_TEST(test_cause_chain);
+#endif
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+    XCEPTEST_RUN_TEST(test_flight_recorder);
+#endif
 
     printf("Result: %d passed, %d failed.\n", XCEPTEST_g_tests_passed, XCEPTEST_g_tests_failed);
     printf("===============================\n");
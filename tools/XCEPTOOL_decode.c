@@ -0,0 +1,176 @@
+// Rebuilds the timeline of a flight recorder file written with XCEP_CONF_ENABLE_FLIGHT_RECORDER: the events of
+// every thread region merged by time. Works on the file of a process that crashed, read it on the same machine.
+
+#include <XCEP.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+	const XCEP_t_RecorderEvent* event;
+	unsigned long long sequence; // Rank in its region, orders the events of one thread with the same time
+	unsigned int region;
+	unsigned long long thread_id;
+} XCEPTOOL_t_Entry;
+
+static void usage(const char* inProgram) {
+	printf("Usage: %s [options] FILE\n", inProgram);
+	printf("  --format=text|csv         Output format (default: text)\n");
+}
+
+static const char* kind_name(const unsigned int inKind) {
+	switch (inKind) {
+		case XCEP_RECORD_THROW: return "throw";
+		case XCEP_RECORD_CATCH: return "catch";
+		case XCEP_RECORD_RETHROW: return "rethrow";
+		case XCEP_RECORD_UNCAUGHT: return "uncaught";
+		default: return "unknown";
+	}
+}
+
+static int compare_entries(const void* inLeft, const void* inRight) {
+	const XCEPTOOL_t_Entry* vLeft = inLeft;
+	const XCEPTOOL_t_Entry* vRight = inRight;
+	if (vLeft->event->time_ns != vRight->event->time_ns) return vLeft->event->time_ns < vRight->event->time_ns ? -1 : 1;
+	if (vLeft->region != vRight->region) return vLeft->region < vRight->region ? -1 : 1;
+	return vLeft->sequence < vRight->sequence ? -1 : vLeft->sequence > vRight->sequence;
+}
+
+static unsigned char* read_file(const char* inPath, size_t* outSize) {
+	FILE* vFile = fopen(inPath, "rb");
+	if (vFile == NULL) return NULL;
+	unsigned char* vData = NULL;
+	if (fseek(vFile, 0, SEEK_END) == 0) {
+		const long vSize = ftell(vFile);
+		if (vSize > 0 && fseek(vFile, 0, SEEK_SET) == 0) {
+			vData = malloc((size_t)vSize);
+			if (vData != NULL && fread(vData, 1, (size_t)vSize, vFile) != (size_t)vSize) {
+				free(vData);
+				vData = NULL;
+			}
+			*outSize = (size_t)vSize;
+		}
+	}
+	fclose(vFile);
+	return vData;
+}
+
+static const char* check_header(const XCEP_t_RecorderHeader* inHeader, const size_t inSize) {
+	if (inSize < sizeof(XCEP_t_RecorderHeader) || memcmp(inHeader->magic, XCEP_RECORDER_MAGIC, sizeof(inHeader->magic)) != 0) {
+		return "not a XCEP flight recorder file";
+	}
+	if (inHeader->version != XCEP_RECORDER_VERSION) return "unsupported version";
+	if (inHeader->header_size != sizeof(XCEP_t_RecorderHeader) || inHeader->event_size != sizeof(XCEP_t_RecorderEvent)) {
+		return "written by a build with another layout";
+	}
+	if (inHeader->region_events == 0 || (inHeader->region_events & (inHeader->region_events - 1)) != 0
+		|| inHeader->region_size < sizeof(XCEP_t_RecorderRegion) + (size_t)inHeader->region_events * inHeader->event_size) {
+		return "inconsistent region size";
+	}
+	if (inSize < inHeader->header_size + (size_t)inHeader->region_count * inHeader->region_size) return "truncated file";
+	return NULL;
+}
+
+int main(const int argc, char** argv) {
+	const char* vPath = NULL;
+	int vCsv = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		const char* vArg = argv[i];
+		if (strcmp(vArg, "--format=csv") == 0) {
+			vCsv = 1;
+		} else if (strcmp(vArg, "--format=text") == 0) {
+			vCsv = 0;
+		} else if (vArg[0] != '-' && vPath == NULL) {
+			vPath = vArg;
+		} else {
+			usage(argv[0]);
+			return strcmp(vArg, "--help") == 0 ? 0 : 2;
+		}
+	}
+	if (vPath == NULL) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	size_t vSize = 0;
+	unsigned char* vData = read_file(vPath, &vSize);
+	if (vData == NULL) {
+		fprintf(stderr, "Cannot read %s\n", vPath);
+		return 1;
+	}
+	const XCEP_t_RecorderHeader* vHeader = (const XCEP_t_RecorderHeader*)vData;
+	const char* vError = check_header(vHeader, vSize);
+	if (vError != NULL) {
+		fprintf(stderr, "%s: %s\n", vPath, vError);
+		free(vData);
+		return 1;
+	}
+
+	// Regions are claimed in order, the ones after regions_claimed were never written
+	const unsigned int vRegions = vHeader->regions_claimed < (long long)vHeader->region_count
+		? (unsigned int)vHeader->regions_claimed : vHeader->region_count;
+	XCEPTOOL_t_Entry* vEntries = malloc(sizeof(XCEPTOOL_t_Entry) * ((size_t)vRegions * vHeader->region_events + 1));
+	if (vEntries == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		free(vData);
+		return 1;
+	}
+
+	size_t vCount = 0;
+	unsigned long long vOverwritten = 0;
+	for (unsigned int r = 0; r < vRegions; ++r) {
+		const XCEP_t_RecorderRegion* vRegion = (const XCEP_t_RecorderRegion*)(vData + vHeader->header_size + (size_t)r * vHeader->region_size);
+		const XCEP_t_RecorderEvent* vEvents = (const XCEP_t_RecorderEvent*)(vRegion + 1);
+		const unsigned long long vHead = vRegion->head;
+		// Once wrapped, the slot of event vHead - region_events may be half overwritten by a writer that crashed
+		const unsigned long long vKept = vHead < vHeader->region_events ? vHead : vHeader->region_events - 1;
+		vOverwritten += vHead - vKept;
+		for (unsigned long long s = vHead - vKept; s < vHead; ++s) {
+			vEntries[vCount++] = (XCEPTOOL_t_Entry){
+				.event = &vEvents[s & (vHeader->region_events - 1)],
+				.sequence = s,
+				.region = r,
+				.thread_id = vRegion->thread_id,
+			};
+		}
+	}
+	qsort(vEntries, vCount, sizeof(XCEPTOOL_t_Entry), compare_entries);
+
+	if (vCsv) {
+		printf("time_ns,region,thread_id,kind,code,function,line,message\n");
+	} else {
+		const time_t vStart = (time_t)(vHeader->start_realtime_ns / 1000000000ull);
+		char vStartText[32] = "?";
+		const struct tm* vStartTm = gmtime(&vStart);
+		if (vStartTm != NULL) strftime(vStartText, sizeof(vStartText), "%Y-%m-%d %H:%M:%S", vStartTm);
+		printf("# pid %llu, opened %s UTC, %u threads recorded, %lld without a region, %zu events, %llu overwritten\n",
+			vHeader->pid, vStartText, vRegions,
+			vHeader->regions_claimed > (long long)vRegions ? vHeader->regions_claimed - (long long)vRegions : 0,
+			vCount, vOverwritten);
+		printf("%14s %6s %10s %-9s %11s  %s\n", "ms", "region", "thread", "kind", "code", "site and message");
+	}
+
+	// The strings of a file left by a crash may lack their '\0', they are printed bounded
+	const int vFunctionSize = (int)sizeof(((XCEP_t_RecorderEvent*)0)->function);
+	const int vMessageSize = (int)sizeof(((XCEP_t_RecorderEvent*)0)->message);
+	for (size_t i = 0; i < vCount; ++i) {
+		const XCEP_t_RecorderEvent* vEvent = vEntries[i].event;
+		if (vCsv) {
+			printf("%llu,%u,%llu,%s,%d,%.*s,%u,\"%.*s\"\n", vEvent->time_ns - vHeader->start_monotonic_ns,
+				vEntries[i].region, vEntries[i].thread_id, kind_name(vEvent->kind), vEvent->code,
+				vFunctionSize, vEvent->function, vEvent->line, vMessageSize, vEvent->message);
+		} else {
+			printf("%14.6f %6u %10llu %-9s %11d  %.*s:%u \"%.*s\"\n",
+				(double)(long long)(vEvent->time_ns - vHeader->start_monotonic_ns) / 1e6,
+				vEntries[i].region, vEntries[i].thread_id, kind_name(vEvent->kind), vEvent->code,
+				vFunctionSize, vEvent->function, vEvent->line, vMessageSize, vEvent->message);
+		}
+	}
+
+	free(vEntries);
+	free(vData);
+	return 0;
+}
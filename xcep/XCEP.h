@@ -22,17 +22,46 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef XCEP_CDAD39BB4CBB62BD_H
 #define XCEP_CDAD39BB4CBB62BD_H
 
-#include <setjmp.h>
-
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
 
 // =========================================================
 // MARK: Configuration
 // =========================================================
 
+// Every option can also be overridden from the build system, ex: -DXCEP_CONF_ENABLE_THREAD_SAFE=0
+
+#ifndef XCEP_CONF_ENABLE_THREAD_SAFE
 #define XCEP_CONF_ENABLE_THREAD_SAFE 1
+#endif
+#ifndef XCEP_CONF_ENABLE_SHORT_COMMANDS
 #define XCEP_CONF_ENABLE_SHORT_COMMANDS 1
+#endif
+#ifndef XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
 #define XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO 1
+#endif
+#ifndef XCEP_CONF_ENABLE_CUSTOM_TYPES
 #define XCEP_CONF_ENABLE_CUSTOM_TYPES 0
+#endif
+
+// Jump backend used by Try to save its context and by Throw to come back to it:
+// - XCEP_JUMP_BACKEND_SETJMP: libc setjmp/longjmp, portable, full jmp_buf
+// - XCEP_JUMP_BACKEND_BUILTIN: __builtin_setjmp/__builtin_longjmp, 5 words, no libc call (GCC/Clang)
+// - XCEP_JUMP_BACKEND_ASM: hand-written callee-saved registers save (x86-64 System V, AArch64)
+// - XCEP_JUMP_BACKEND_SIGSETJMP: POSIX sigsetjmp/siglongjmp, also restores the signal mask (one syscall per Try)
+// - XCEP_JUMP_BACKEND_UNWIND: nothing saved by Try, Throw runs a forced unwind of the -fexceptions tables up to
+//   a cleanup landing pad of the Try (GCC on Linux, the code using Try must be built with -fexceptions)
+// Unsupported choices fall back to the next portable one.
+#define XCEP_JUMP_BACKEND_SETJMP 0
+#define XCEP_JUMP_BACKEND_BUILTIN 1
+#define XCEP_JUMP_BACKEND_ASM 2
+#define XCEP_JUMP_BACKEND_SIGSETJMP 3
+#define XCEP_JUMP_BACKEND_UNWIND 4
+
+#ifndef XCEP_CONF_JUMP_BACKEND
+#define XCEP_CONF_JUMP_BACKEND XCEP_JUMP_BACKEND_SETJMP
+#endif
 
 #if XCEP_CONF_ENABLE_CUSTOM_TYPES
 
@@ -67,6 +96,406 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 	#error "Cannot determine thread-local storage specifier"
 #endif
 
+// Thread-local storage access model of the per-thread context (GCC/Clang, ELF):
+// - XCEP_TLS_MODEL_DEFAULT: let the compiler decide (global-dynamic when built with -fPIC)
+// - XCEP_TLS_MODEL_GLOBAL_DYNAMIC: always valid, may call __tls_get_addr on every access
+// - XCEP_TLS_MODEL_INITIAL_EXEC: one load from the thread pointer, XCEP must not be in a dlopen'ed library
+// - XCEP_TLS_MODEL_LOCAL_EXEC: fastest, XCEP must be linked into the executable itself
+#define XCEP_TLS_MODEL_DEFAULT 0
+#define XCEP_TLS_MODEL_GLOBAL_DYNAMIC 1
+#define XCEP_TLS_MODEL_INITIAL_EXEC 2
+#define XCEP_TLS_MODEL_LOCAL_EXEC 3
+
+#ifndef XCEP_CONF_TLS_MODEL
+#define XCEP_CONF_TLS_MODEL XCEP_TLS_MODEL_DEFAULT
+#endif
+
+#if !XCEP_CONF_ENABLE_THREAD_SAFE || !(defined(__clang__) || defined(__GNUC__)) || defined(_WIN32)
+	#define XCEP___TLS_MODEL
+#elif XCEP_CONF_TLS_MODEL == XCEP_TLS_MODEL_DEFAULT
+	#define XCEP___TLS_MODEL
+#elif XCEP_CONF_TLS_MODEL == XCEP_TLS_MODEL_GLOBAL_DYNAMIC
+	#define XCEP___TLS_MODEL __attribute__((tls_model("global-dynamic")))
+#elif XCEP_CONF_TLS_MODEL == XCEP_TLS_MODEL_INITIAL_EXEC
+	#define XCEP___TLS_MODEL __attribute__((tls_model("initial-exec")))
+#elif XCEP_CONF_TLS_MODEL == XCEP_TLS_MODEL_LOCAL_EXEC
+	#define XCEP___TLS_MODEL __attribute__((tls_model("local-exec")))
+#else
+	#error "Unknown XCEP_CONF_TLS_MODEL, use one of the XCEP_TLS_MODEL_* values"
+#endif
+
+#if defined(_MSC_VER)
+	#define XCEP___INLINE static __inline
+#else
+	#define XCEP___INLINE static inline
+#endif
+
+#if defined(_MSC_VER)
+	#define XCEP___NOINLINE __declspec(noinline)
+#elif defined(__clang__) || defined(__GNUC__)
+	#define XCEP___NOINLINE __attribute__((noinline))
+#else
+	#define XCEP___NOINLINE
+#endif
+
+// Leading a member declaration: the member, and so its struct, starts on its own cache line
+#if defined(_MSC_VER)
+	#define XCEP___CACHE_ALIGNED __declspec(align(64))
+#elif defined(__clang__) || defined(__GNUC__)
+	#define XCEP___CACHE_ALIGNED __attribute__((aligned(64)))
+#else
+	#define XCEP___CACHE_ALIGNED
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+	#define XCEP___PRINTF_FORMAT(_format_index, _args_index) __attribute__((format(printf, _format_index, _args_index)))
+	#define XCEP___UNLIKELY(_condition) __builtin_expect(!!(_condition), 0)
+#else
+	#define XCEP___PRINTF_FORMAT(_format_index, _args_index)
+	#define XCEP___UNLIKELY(_condition) (_condition)
+#endif
+
+// Throwing functions are noreturn and cold, the compiler moves every throw path out of line.
+// Uncaught exception handlers must then not return (exit, abort or jump away), XCEP aborts when one does.
+#ifndef XCEP_CONF_STRICT_THROW
+#define XCEP_CONF_STRICT_THROW 0
+#endif
+
+// Functions that throw, only noreturn in strict mode: by default they come back when an uncaught handler returns
+#if !XCEP_CONF_STRICT_THROW
+	#define XCEP___THROWING
+#elif defined(_MSC_VER)
+	#define XCEP___THROWING __declspec(noreturn)
+#elif defined(__clang__) || defined(__GNUC__)
+	#define XCEP___THROWING __attribute__((noreturn, cold))
+#else
+	#define XCEP___THROWING
+#endif
+
+// =========================================================
+// MARK: Atomics
+// =========================================================
+
+// Minimal set on `volatile long` objects for the parts of XCEP shared between threads
+#if defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+	// volatile accesses have acquire/release semantics with /volatile:ms, the default on x86 and x64
+	#define XCEP___AtomicLoad(_ptr) (*(_ptr))
+	#define XCEP___AtomicStore(_ptr, _val) (*(_ptr) = (_val))
+	#define XCEP___AtomicCas(_ptr, _expected, _desired) (_InterlockedCompareExchange((_ptr), (_desired), (_expected)) == (_expected))
+	#define XCEP___AtomicCasPtr(_ptr, _expected, _desired) (_InterlockedCompareExchangePointer((void* volatile*)(_ptr), (_desired), (_expected)) == (void*)(_expected))
+	// Counters are `volatile long long`, only their own value has to be atomic
+	#define XCEP___AtomicAddRelaxed(_ptr, _val) _InterlockedExchangeAdd64((_ptr), (_val))
+	#define XCEP___AtomicLoadRelaxed(_ptr) (*(_ptr))
+	// Returns the previous value
+	#define XCEP___AtomicAdd(_ptr, _val) _InterlockedExchangeAdd((_ptr), (_val))
+	// Interlocked operations are full barriers
+	#define XCEP___AtomicFence() do { volatile long XCEP_v_fence = 0; _InterlockedExchange(&XCEP_v_fence, 0); } while (0)
+#else
+	#define XCEP___AtomicLoad(_ptr) __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+	#define XCEP___AtomicStore(_ptr, _val) __atomic_store_n((_ptr), (_val), __ATOMIC_RELEASE)
+	#define XCEP___AtomicCas(_ptr, _expected, _desired) __sync_bool_compare_and_swap((_ptr), (_expected), (_desired))
+	#define XCEP___AtomicCasPtr(_ptr, _expected, _desired) __sync_bool_compare_and_swap((_ptr), (_expected), (_desired))
+	#define XCEP___AtomicAddRelaxed(_ptr, _val) __atomic_fetch_add((_ptr), (_val), __ATOMIC_RELAXED)
+	#define XCEP___AtomicLoadRelaxed(_ptr) __atomic_load_n((_ptr), __ATOMIC_RELAXED)
+	#define XCEP___AtomicAdd(_ptr, _val) __atomic_fetch_add((_ptr), (_val), __ATOMIC_ACQ_REL)
+	#define XCEP___AtomicFence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+// Codes thrown by XCEP itself are XCEP_CONF_ERROR_CODE_BASE - n, see "Library Error Codes"
+#ifndef XCEP_CONF_ERROR_CODE_BASE
+#define XCEP_CONF_ERROR_CODE_BASE (-100)
+#endif
+
+// Uncaught exception subscribers (XCEP_AddUncaughtExceptionHandler) all called before the handler in charge
+#ifndef XCEP_CONF_HANDLER_SUBSCRIBERS
+#define XCEP_CONF_HANDLER_SUBSCRIBERS 8
+#endif
+// Slots of the open-addressed table of per-code uncaught handlers, a power of two. A code keeps its slot once set.
+#ifndef XCEP_CONF_HANDLER_TABLE_SIZE
+#define XCEP_CONF_HANDLER_TABLE_SIZE 64
+#endif
+
+#if XCEP_CONF_HANDLER_TABLE_SIZE & (XCEP_CONF_HANDLER_TABLE_SIZE - 1)
+#error "XCEP_CONF_HANDLER_TABLE_SIZE must be a power of two"
+#endif
+
+// With extra info, every Throw expansion emits a static site record (file, function, line) in the xcep_sites
+// linker section and exceptions only carry its 32-bit index: smaller per-thread state and throw copy (ELF, GCC/Clang).
+// All the throwing code must be linked in the same module (executable or shared object) as the implementation.
+#ifndef XCEP_CONF_ENABLE_COMPACT_SITES
+#define XCEP_CONF_ENABLE_COMPACT_SITES 0
+#endif
+
+#if XCEP_CONF_ENABLE_COMPACT_SITES && !(defined(__GNUC__) && defined(__ELF__))
+#error "XCEP_CONF_ENABLE_COMPACT_SITES needs an ELF target and GCC or Clang"
+#endif
+
+// Contexts owned by fibers: each thread reaches its current XCEP_t_Context through a pointer that a user-space
+// scheduler swaps with XCEP_ContextSwitch/XCEP_ContextBind. Costs one more load and branch per context lookup.
+#ifndef XCEP_CONF_ENABLE_CONTEXT_SWITCH
+#define XCEP_CONF_ENABLE_CONTEXT_SWITCH 0
+#endif
+
+// Per-thread cleanup stack used by XCEP_Defer, cleanups are run when a Throw unwinds past them
+#ifndef XCEP_CONF_ENABLE_DEFER
+#define XCEP_CONF_ENABLE_DEFER 1
+#endif
+#ifndef XCEP_CONF_DEFER_STACK_SIZE
+#define XCEP_CONF_DEFER_STACK_SIZE 64
+#endif
+
+// Exception types declared with a parent and caught with CatchType, subtype checks are O(1)
+#ifndef XCEP_CONF_ENABLE_EXCEPTION_TYPES
+#define XCEP_CONF_ENABLE_EXCEPTION_TYPES 1
+#endif
+// Maximum depth of the type hierarchy, the root Exception type included
+#ifndef XCEP_CONF_TYPE_MAX_DEPTH
+#define XCEP_CONF_TYPE_MAX_DEPTH 8
+#endif
+
+// Per-thread ring arena ThrowF formats its messages into, 0 removes ThrowF
+#ifndef XCEP_CONF_MESSAGE_ARENA_SIZE
+#define XCEP_CONF_MESSAGE_ARENA_SIZE 1024
+#endif
+// Longest formatted message, terminator included. The arena is split in ARENA_SIZE / MESSAGE_MAX_SIZE
+// slots used in turn: that many last messages of a thread stay valid, older ones are overwritten. The slot of
+// an exception a Catch is handling is skipped until its Try ends, with every slot pinned ThrowF throws its format.
+#ifndef XCEP_CONF_MESSAGE_MAX_SIZE
+#define XCEP_CONF_MESSAGE_MAX_SIZE 256
+#endif
+// What happens to longer messages:
+// - XCEP_TRUNCATE_CUT: cut at MESSAGE_MAX_SIZE - 1 characters
+// - XCEP_TRUNCATE_ELLIPSIS: same, the last 3 characters kept are replaced by "..."
+#define XCEP_TRUNCATE_CUT 0
+#define XCEP_TRUNCATE_ELLIPSIS 1
+
+#ifndef XCEP_CONF_MESSAGE_TRUNCATION
+#define XCEP_CONF_MESSAGE_TRUNCATION XCEP_TRUNCATE_ELLIPSIS
+#endif
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE && (XCEP_CONF_MESSAGE_MAX_SIZE < 4 || XCEP_CONF_MESSAGE_MAX_SIZE > XCEP_CONF_MESSAGE_ARENA_SIZE)
+#error "XCEP_CONF_MESSAGE_MAX_SIZE must be between 4 and XCEP_CONF_MESSAGE_ARENA_SIZE"
+#endif
+#define XCEP___MESSAGE_SLOTS (XCEP_CONF_MESSAGE_ARENA_SIZE / XCEP_CONF_MESSAGE_MAX_SIZE)
+
+// Bytes of the per-thread buffer ThrowWith copies its payload into, 0 removes ThrowWith
+#ifndef XCEP_CONF_PAYLOAD_SIZE
+#define XCEP_CONF_PAYLOAD_SIZE 64
+#endif
+
+// Return addresses recorded per throw by a frame-pointer walk, 0 disables the capture.
+// Needs -fno-omit-frame-pointer (GCC/Clang, x86/x86-64/AArch64), uses RtlCaptureStackBackTrace on Windows.
+#ifndef XCEP_CONF_BACKTRACE_DEPTH
+#define XCEP_CONF_BACKTRACE_DEPTH 0
+#endif
+// Default for XCEP_SetBacktraceSampling: capture 1 throw in N per thread, 0 never captures
+#ifndef XCEP_CONF_BACKTRACE_SAMPLING
+#define XCEP_CONF_BACKTRACE_SAMPLING 1
+#endif
+
+// Per-throw-site counters of thrown, caught, rethrown and uncaught exceptions, read with XCEP_StatsSnapshot
+#ifndef XCEP_CONF_ENABLE_STATS
+#define XCEP_CONF_ENABLE_STATS 0
+#endif
+// Counter copies per site, threads are spread over them to avoid sharing cache lines
+#ifndef XCEP_CONF_STATS_SHARDS
+#define XCEP_CONF_STATS_SHARDS 8
+#endif
+
+// Per-thread Try nesting depth and its high-water mark (XCEP_GetTryDepth), aggregated process-wide for
+// XCEP_TryDepthSnapshot. Only entering a Try deeper than the thread ever went takes the slow path.
+#ifndef XCEP_CONF_ENABLE_DEPTH_STATS
+#define XCEP_CONF_ENABLE_DEPTH_STATS 0
+#endif
+// Deepest Try nesting allowed per thread, 0 is no limit. Entering one more Try throws XCEP_ERR_TRY_DEPTH to the
+// enclosing Try instead, ex: a recursive parser fails cleanly before its frames overflow the stack.
+#ifndef XCEP_CONF_TRY_DEPTH_LIMIT
+#define XCEP_CONF_TRY_DEPTH_LIMIT 0
+#endif
+
+#define XCEP___TRACK_DEPTH (XCEP_CONF_ENABLE_DEPTH_STATS || XCEP_CONF_TRY_DEPTH_LIMIT)
+
+// Throw-to-catch latency in ticks of a cycle counter (rdtsc, CNTVCT, a monotonic clock in ns elsewhere) and frames
+// landed in until a Catch takes the exception, in log-linear histograms per code read with XCEP_LatencySnapshot
+#ifndef XCEP_CONF_ENABLE_LATENCY
+#define XCEP_CONF_ENABLE_LATENCY 0
+#endif
+// Codes with their own histograms, a power of two. The codes caught once every one is taken share one more.
+#ifndef XCEP_CONF_LATENCY_CODES
+#define XCEP_CONF_LATENCY_CODES 32
+#endif
+// Histogram copies, threads are spread over them as over the stats shards
+#ifndef XCEP_CONF_LATENCY_SHARDS
+#define XCEP_CONF_LATENCY_SHARDS 4
+#endif
+
+#if XCEP_CONF_ENABLE_LATENCY && (XCEP_CONF_LATENCY_CODES & (XCEP_CONF_LATENCY_CODES - 1)) != 0
+#error "XCEP_CONF_LATENCY_CODES must be a power of two"
+#endif
+
+// XCEP_PrintException, the default uncaught handler and optionally every throw push fixed-size records
+// into a lock-free ring drained by a background thread (XCEP_LogStart) instead of writing to stderr.
+// The records of printed exceptions carry their XCEP_CONF_BACKTRACE_DEPTH frames, every record grows by as many pointers.
+#ifndef XCEP_CONF_ENABLE_ASYNC_LOG
+#define XCEP_CONF_ENABLE_ASYNC_LOG 0
+#endif
+// Records in the ring, a power of two. Records pushed while it is full are dropped and counted.
+#ifndef XCEP_CONF_LOG_RING_SIZE
+#define XCEP_CONF_LOG_RING_SIZE 1024
+#endif
+// Bytes of the message copied in a record, the message of a ThrowF does not outlive its arena slot
+#ifndef XCEP_CONF_LOG_MESSAGE_SIZE
+#define XCEP_CONF_LOG_MESSAGE_SIZE 128
+#endif
+// Log every throw, not only the printed and the uncaught exceptions
+#ifndef XCEP_CONF_LOG_THROWS
+#define XCEP_CONF_LOG_THROWS 1
+#endif
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG && (XCEP_CONF_LOG_RING_SIZE & (XCEP_CONF_LOG_RING_SIZE - 1)) != 0
+#error "XCEP_CONF_LOG_RING_SIZE must be a power of two"
+#endif
+
+// Size of the message copy kept by XCEP_CaptureException
+#ifndef XCEP_CONF_CAPTURED_MESSAGE_SIZE
+#define XCEP_CONF_CAPTURED_MESSAGE_SIZE 256
+#endif
+// Causes kept per thread by ThrowWithCause, a longer chain drops its oldest ones. 0 removes ThrowWithCause.
+#ifndef XCEP_CONF_CAUSE_DEPTH
+#define XCEP_CONF_CAUSE_DEPTH 4
+#endif
+// Size of the message copy kept per cause
+#ifndef XCEP_CONF_CAUSE_MESSAGE_SIZE
+#define XCEP_CONF_CAUSE_MESSAGE_SIZE 128
+#endif
+
+// Flight recorder: every thread appends its throws and catches to its own region of a file mapped by
+// XCEP_RecorderOpen, with plain stores. The file outlives a crash of the process, the xcep_decode tool reads it (POSIX).
+#ifndef XCEP_CONF_ENABLE_FLIGHT_RECORDER
+#define XCEP_CONF_ENABLE_FLIGHT_RECORDER 0
+#endif
+// Regions of the file, one per recorded thread or fiber context, the threads coming after the last are not recorded
+#ifndef XCEP_CONF_RECORDER_REGIONS
+#define XCEP_CONF_RECORDER_REGIONS 64
+#endif
+// Events kept per region, a power of two, the oldest are overwritten
+#ifndef XCEP_CONF_RECORDER_EVENTS
+#define XCEP_CONF_RECORDER_EVENTS 1024
+#endif
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER && defined(_WIN32)
+#error "XCEP_CONF_ENABLE_FLIGHT_RECORDER needs mmap, it is POSIX only"
+#endif
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER && (XCEP_CONF_RECORDER_EVENTS & (XCEP_CONF_RECORDER_EVENTS - 1)) != 0
+#error "XCEP_CONF_RECORDER_EVENTS must be a power of two"
+#endif
+// XCEP_ThreadStart/XCEP_ThreadJoin, threads whose uncaught exception is rethrown by join (needs pthread on POSIX)
+#ifndef XCEP_CONF_ENABLE_THREAD_API
+#define XCEP_CONF_ENABLE_THREAD_API 0
+#endif
+// Threads of a XCEP_t_TaskGroup at most, the one waiting for the group included (THREAD_API only)
+#ifndef XCEP_CONF_TASK_MAX_WORKERS
+#define XCEP_CONF_TASK_MAX_WORKERS 8
+#endif
+// Tasks queued per worker, a task pushed on a full deque runs at once in the pushing thread
+#ifndef XCEP_CONF_TASK_QUEUE_SIZE
+#define XCEP_CONF_TASK_QUEUE_SIZE 256
+#endif
+// Exceptions a group keeps for XCEP_TASK_RETHROW_ALL, the following ones are only counted
+#ifndef XCEP_CONF_TASK_MAX_ERRORS
+#define XCEP_CONF_TASK_MAX_ERRORS 8
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API && (XCEP_CONF_TASK_QUEUE_SIZE & (XCEP_CONF_TASK_QUEUE_SIZE - 1)) != 0
+#error "XCEP_CONF_TASK_QUEUE_SIZE must be a power of two"
+#endif
+
+// Turns SIGSEGV, SIGBUS, SIGFPE and SIGILL raised in a Try into exceptions once XCEP_SignalsInstall is called (POSIX).
+// Backends other than SIGSETJMP do not restore the signal mask, the handler unblocks its signal itself before jumping.
+#ifndef XCEP_CONF_ENABLE_SIGNALS
+#define XCEP_CONF_ENABLE_SIGNALS 0
+#endif
+// Per-thread alternate stack the handler runs on, a stack overflow in a Try is caught as well.
+// Mapped by XCEP_SignalsThreadInit and unmapped when its thread exits.
+#ifndef XCEP_CONF_SIGNAL_STACK_SIZE
+#define XCEP_CONF_SIGNAL_STACK_SIZE 32768
+#endif
+
+#if XCEP_CONF_ENABLE_SIGNALS && defined(_WIN32)
+#error "XCEP_CONF_ENABLE_SIGNALS needs POSIX signals"
+#endif
+
+// CatchAny compares the thrown code against its packed code list with SSE2/NEON when available
+#ifndef XCEP_CONF_ENABLE_SIMD_DISPATCH
+#define XCEP_CONF_ENABLE_SIMD_DISPATCH 1
+#endif
+
+// Two-phase throw: TryFilter frames store what they catch, a throw first searches the chain of frames and lands in
+// the first Try able to take it in one jump. The TryFilter frames passed over only get their Defer cleanups run.
+#ifndef XCEP_CONF_ENABLE_TWO_PHASE
+#define XCEP_CONF_ENABLE_TWO_PHASE 0
+#endif
+
+// =========================================================
+// MARK: Jump Backend
+// =========================================================
+
+#if XCEP_CONF_JUMP_BACKEND == XCEP_JUMP_BACKEND_ASM && (defined(__clang__) || defined(__GNUC__)) && !defined(_WIN32) \
+	&& (defined(__x86_64__) || defined(__aarch64__))
+	#define XCEP___JUMP_BACKEND XCEP_JUMP_BACKEND_ASM
+#elif XCEP_CONF_JUMP_BACKEND == XCEP_JUMP_BACKEND_SIGSETJMP && !defined(_WIN32)
+	#define XCEP___JUMP_BACKEND XCEP_JUMP_BACKEND_SIGSETJMP
+#elif XCEP_CONF_JUMP_BACKEND == XCEP_JUMP_BACKEND_UNWIND && defined(__GNUC__) && !defined(__clang__) && defined(__linux__)
+	// Landing pads need nested functions (GCC only) and the unwind tables of -fexceptions
+	#if !defined(__EXCEPTIONS)
+		#error "XCEP_JUMP_BACKEND_UNWIND needs -fexceptions"
+	#endif
+	#define XCEP___JUMP_BACKEND XCEP_JUMP_BACKEND_UNWIND
+#elif XCEP_CONF_JUMP_BACKEND != XCEP_JUMP_BACKEND_SETJMP && XCEP_CONF_JUMP_BACKEND != XCEP_JUMP_BACKEND_SIGSETJMP && (defined(__GNUC__) && !defined(__clang__) \
+	|| defined(__clang__) && (defined(__i386__) || defined(__x86_64__) || defined(__powerpc__) || defined(__s390x__)))
+	#define XCEP___JUMP_BACKEND XCEP_JUMP_BACKEND_BUILTIN
+#else
+	#define XCEP___JUMP_BACKEND XCEP_JUMP_BACKEND_SETJMP
+#endif
+
+#if XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_ASM
+	#if defined(__x86_64__)
+		// rbx, rbp, r12-r15, rsp, return address
+		typedef void* XCEP_t_JmpBuf[8];
+	#else
+		// x19-x28, x29, x30, sp, d8-d15
+		typedef void* XCEP_t_JmpBuf[21];
+	#endif
+	int XCEP___AsmSetJmp(XCEP_t_JmpBuf inEnv) __attribute__((returns_twice, nothrow));
+	void XCEP___AsmLongJmp(XCEP_t_JmpBuf inEnv) __attribute__((noreturn, nothrow));
+	#define XCEP___SetJmp(_env) XCEP___AsmSetJmp(_env)
+	#define XCEP___LongJmp(_env) XCEP___AsmLongJmp(_env)
+#elif XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_BUILTIN
+	// frame pointer, resume address, stack pointer and two words of target scratch
+	typedef void* XCEP_t_JmpBuf[5];
+	#define XCEP___SetJmp(_env) __builtin_setjmp(_env)
+	#define XCEP___LongJmp(_env) __builtin_longjmp((_env), 1)
+#elif XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_UNWIND
+	// pending: a Throw is unwinding to this frame, landed: its landing pad jumped back into the Try
+	typedef struct {
+		volatile unsigned char pending;
+		volatile unsigned char landed;
+	} XCEP_t_JmpBuf;
+	void XCEP___UnwindTo(XCEP_t_JmpBuf* inEnv) __attribute__((noreturn));
+	#define XCEP___LongJmp(_env) XCEP___UnwindTo(&(_env))
+#elif XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_SIGSETJMP
+	#include <setjmp.h>
+	typedef sigjmp_buf XCEP_t_JmpBuf;
+	#define XCEP___SetJmp(_env) sigsetjmp((_env), 1)
+	#define XCEP___LongJmp(_env) siglongjmp((_env), XCEP_TRUE)
+#else
+	#include <setjmp.h>
+	typedef jmp_buf XCEP_t_JmpBuf;
+	#define XCEP___SetJmp(_env) setjmp(_env)
+	#define XCEP___LongJmp(_env) longjmp((_env), XCEP_TRUE)
+#endif
+
 // =========================================================
 // MARK: Types
 // =========================================================
@@ -86,18 +515,101 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 	#define XCEP_FALSE ((XCEP_t_Bool)false)
 #endif
 
+struct XCEP_t_Type;
+struct XCEP_t_ThrowSite;
+struct XCEP_t_Filter;
+
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+// Static record of one throw site, ids are 1 + its index in the xcep_sites section, 0 is an unknown site
+typedef struct {
+	const char* file;
+	const char* function;
+	XCEP_t_Int line;
+} XCEP_t_SiteRecord;
+#endif
+
 typedef struct {
 	XCEP_t_Int code;
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+	XCEP_t_Uint site_id; // Packed with the code, see XCEP_SiteLookup
+#endif
 	const char* message;
-#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && !XCEP_CONF_ENABLE_COMPACT_SITES
 	XCEP_t_Int line;
 	const char* file;
 	const char* function;
 #endif
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+	const struct XCEP_t_Type* type; // NULL for plain codes, seen as the root Exception type
+#endif
+#if XCEP_CONF_PAYLOAD_SIZE
+	XCEP_t_Uint payload_size; // 0 when thrown without payload
+#endif
+#if XCEP_CONF_ENABLE_STATS
+	struct XCEP_t_ThrowSite* site; // NULL when not thrown by a Throw macro
+#endif
 } XCEP_t_Exception;
 
+#if XCEP_CONF_ENABLE_STATS
+typedef enum {
+	XCEP_STATS_THROWN,
+	XCEP_STATS_CAUGHT,   // Handled by a Catch of the Try it reached
+	XCEP_STATS_RETHROWN, // Counted once per Rethrow
+	XCEP_STATS_UNCAUGHT, // Reached the uncaught exception handling
+	XCEP_STATS_COUNT
+} XCEP_t_StatsCounter;
+
+// Static descriptor of one Throw expansion, linked in the site list on its first throw
+typedef struct XCEP_t_ThrowSite {
+	const char* file;
+	const char* function;
+	XCEP_t_Int line;
+	XCEP_t_Int code; // Code of the first throw, a site can throw a runtime code
+	volatile long registered;
+	struct XCEP_t_ThrowSite* volatile next;
+	struct {
+		XCEP___CACHE_ALIGNED volatile long long counters[XCEP_STATS_COUNT];
+		long long padding[8 - XCEP_STATS_COUNT]; // One 64 bytes cache line per shard
+	} shards[XCEP_CONF_STATS_SHARDS];
+} XCEP_t_ThrowSite;
+
+#if defined(_MSC_VER) || defined(__clang__) || defined(__GNUC__)
+// Compile error (negative array size) when a shard would share a cache line with the header or another shard
+typedef char XCEP___t_StatsShardCheck[
+	(sizeof(((XCEP_t_ThrowSite*)0)->shards[0]) == 64 && offsetof(XCEP_t_ThrowSite, shards) % 64 == 0) ? 1 : -1];
+#endif
+
+typedef struct {
+	const XCEP_t_ThrowSite* site;
+	long long counters[XCEP_STATS_COUNT];
+} XCEP_t_SiteStats;
+#endif
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+// Ancestors are stored by depth (a "display"), so "is T a subtype of S" is display[S.depth] == S.
+// The display is filled on the first throw of the type by copying the parent's one.
+typedef struct XCEP_t_Type {
+	const char* name;
+	struct XCEP_t_Type* parent;
+	XCEP_t_Int code;
+	volatile long state;
+	XCEP_t_Uint depth;
+	const struct XCEP_t_Type* display[XCEP_CONF_TYPE_MAX_DEPTH];
+} XCEP_t_Type;
+#endif
+
+typedef void (*XCEP_t_DeferFunc)(void*);
+
+typedef struct {
+	XCEP_t_DeferFunc func;
+	void* arg;
+} XCEP_t_Deferred;
+
 typedef struct XCEP_t_Frame {
-	jmp_buf env;
+	XCEP_t_JmpBuf env;
+#if XCEP_CONF_ENABLE_DEFER
+	XCEP_t_Uint defer_mark;
+#endif
 	struct {
 		XCEP_t_Bool run_once : 1;
 		XCEP_t_Bool thrown : 1;
@@ -106,26 +618,245 @@ typedef struct XCEP_t_Frame {
 		XCEP_t_Bool have_been_handled: 1;
 	} state_flags;
 	struct XCEP_t_Frame* prev;
+#if XCEP_CONF_ENABLE_TWO_PHASE
+	const struct XCEP_t_Filter* filter; // NULL for a plain Try, always landed in
+#endif
+	XCEP_t_Exception handled; // Taken by its Catch, what Rethrow propagates whatever was thrown and caught since
+#if XCEP_CONF_CAUSE_DEPTH
+	XCEP_t_Uint cause_mark;  // cause_count of the context when its Catch started
+	XCEP_t_Uint cause_chain; // Length of the chain of handled then
+#endif
 } XCEP_t_Frame;
 
 typedef void (*XCEP_t_ExceptionHandler)(const XCEP_t_Exception*);
+// Accepts or refuses an exception, CatchWhen and XCEP_FilterWhen must not throw
+typedef XCEP_t_Bool (*XCEP_t_ExceptionPredicate)(const XCEP_t_Exception*);
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+// What a TryFilter catches: any of the codes, the range when has_range is set, or what the predicate accepts
+typedef struct XCEP_t_Filter {
+	const XCEP_t_Int* codes;
+	XCEP_t_Uint code_count;
+	XCEP_t_Bool has_range;
+	XCEP_t_Int low;
+	XCEP_t_Int high;
+	XCEP_t_ExceptionPredicate when;
+} XCEP_t_Filter;
+#endif
+
+#if XCEP_CONF_PAYLOAD_SIZE
+// Payload bytes, the union only gives them the strictest usual alignment
+typedef union {
+	unsigned char bytes[XCEP_CONF_PAYLOAD_SIZE];
+	long double align_float;
+	long long align_int;
+	void* align_pointer;
+} XCEP_t_Payload;
+#endif
+
+#if XCEP_CONF_ENABLE_SIGNALS
+// Payload of the exceptions thrown by the signal handler, read it with CaughtPayload(XCEP_t_SignalInfo)
+typedef struct {
+	int signal;
+	int code;      // siginfo_t.si_code, ex: SEGV_MAPERR
+	void* address; // siginfo_t.si_addr, the faulting address
+} XCEP_t_SignalInfo;
+#endif
+
+// Self-contained copy of a caught exception, can be moved to another thread and rethrown there
+typedef struct {
+	XCEP_t_Bool has_exception;
+	XCEP_t_Exception exception; // exception.message is NULL, the text is in message
+	char message[XCEP_CONF_CAPTURED_MESSAGE_SIZE];
+#if XCEP_CONF_PAYLOAD_SIZE
+	XCEP_t_Payload payload;
+#endif
+} XCEP_t_ExceptionPtr;
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+#define XCEP_RECORDER_MAGIC "XCEPREC"
+#define XCEP_RECORDER_VERSION 1
+
+// Kinds of events
+#define XCEP_RECORD_THROW 1
+#define XCEP_RECORD_CATCH 2
+#define XCEP_RECORD_RETHROW 3
+#define XCEP_RECORD_UNCAUGHT 4
+
+// Layout of the file, in the byte order of the writer: this header, then region_count regions of region_size bytes.
+// A region is a XCEP_t_RecorderRegion followed by a ring of region_events events.
+typedef struct {
+	char magic[8];                         // XCEP_RECORDER_MAGIC
+	unsigned int version;
+	unsigned int header_size;
+	unsigned int region_size;
+	unsigned int region_count;
+	unsigned int region_events;
+	unsigned int event_size;
+	unsigned long long pid;
+	unsigned long long start_monotonic_ns; // CLOCK_MONOTONIC when the file was opened, events use the same clock
+	unsigned long long start_realtime_ns;  // Wall clock at the same time
+	volatile long long regions_claimed;    // Above region_count when threads found no region left
+} XCEP_t_RecorderHeader;
+
+typedef struct XCEP_t_RecorderRegion {
+	unsigned long long thread_id;          // gettid() on Linux, pthread_threadid_np() on macOS
+	volatile unsigned long long head;      // Events appended so far, the last region_events - 1 of them are complete
+	unsigned char reserved[48];            // The events start on a cache line
+} XCEP_t_RecorderRegion;
+
+// One cache line per event, the strings are cut to fit and end with '\0' unless the writer died while copying them
+typedef struct {
+	unsigned long long time_ns;            // CLOCK_MONOTONIC
+	int code;
+	unsigned int line;                     // 0 without extra exception info
+	unsigned char kind;                    // XCEP_RECORD_*
+	char function[23];
+	char message[24];
+} XCEP_t_RecorderEvent;
+#endif
+
+#if XCEP_CONF_CAUSE_DEPTH
+// Exception linked by ThrowWithCause, exception.message points at message
+typedef struct {
+	XCEP_t_Exception exception;
+	char message[XCEP_CONF_CAUSE_MESSAGE_SIZE];
+} XCEP_t_Cause;
+#endif
+
+// Everything Try, Throw and EndTry need from the current thread, kept together so it is reached with one TLS lookup
+typedef struct XCEP_t_Context {
+	XCEP_t_Frame* stack;
+	XCEP_t_Exception last_exception;
+#if XCEP_CONF_PAYLOAD_SIZE
+	XCEP_t_Payload payload; // Payload of last_exception
+#endif
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+	XCEP_t_ExceptionHandler uncaught_handler;
+#endif
+#if XCEP_CONF_ENABLE_DEFER
+	XCEP_t_Uint defer_top;
+	XCEP_t_Deferred defer_stack[XCEP_CONF_DEFER_STACK_SIZE];
+#endif
+#if XCEP___TRACK_DEPTH
+	XCEP_t_Uint try_depth;     // Try frames of this context on the stack
+	XCEP_t_Uint try_depth_max; // High-water mark of try_depth
+#endif
+#if XCEP_CONF_ENABLE_LATENCY
+	unsigned long long latency_start; // Ticks when the exception being dispatched was thrown
+	XCEP_t_Uint latency_hops;         // Frames it landed in so far
+	XCEP_t_Uint latency_shard;        // 1 + shard of the histograms used by this thread, 0 until its first catch
+#endif
+#if XCEP_CONF_ENABLE_STATS
+	XCEP_t_Uint stats_shard; // 1 + shard of the site counters used by this thread, 0 until its first throw
+#endif
+#if XCEP_CONF_BACKTRACE_DEPTH
+	// Raw return addresses of the last throw, innermost first, 0 entries when it was not sampled
+	XCEP_t_Uint backtrace_size;
+	XCEP_t_Uint backtrace_countdown;
+	XCEP_t_Int backtrace_code;
+	const char* backtrace_message;
+	void* backtrace[XCEP_CONF_BACKTRACE_DEPTH];
+#endif
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+	XCEP_t_Uint message_slot;
+	XCEP_t_Uint message_pins[XCEP___MESSAGE_SLOTS]; // Catch blocks handling the message of each slot
+	char message_arena[XCEP_CONF_MESSAGE_ARENA_SIZE];
+#endif
+#if XCEP_CONF_CAUSE_DEPTH
+	// Ring of causes, the chain of the last thrown exception is made of its cause_length newest entries
+	XCEP_t_Uint cause_top;     // Next slot written
+	XCEP_t_Uint cause_count;   // Causes written so far, tells a Catch whether its chain was written over
+	XCEP_t_Uint cause_length;
+	XCEP_t_Uint cause_pending; // Chain length of the exception being thrown by ThrowWithCause
+	XCEP_t_Int cause_code;     // Last thrown exception, the owner of the chain
+	const char* cause_message;
+	XCEP_t_Cause causes[XCEP_CONF_CAUSE_DEPTH];
+#endif
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+	XCEP_t_RecorderRegion* recorder_region; // NULL when not recording
+	long recorder_generation;               // Recorder file the region belongs to, claimed again when it changes
+#endif
+} XCEP_t_Context;
 
 // =========================================================
-// MARK: Stack
+// MARK: Context
 // =========================================================
 
-extern XCEP_THREAD_LOCAL XCEP_t_Frame* XCEP_g_Stack;
-extern XCEP_THREAD_LOCAL XCEP_t_Exception XCEP_g_LastException;
+extern XCEP_THREAD_LOCAL XCEP_t_Context XCEP_g_Context XCEP___TLS_MODEL;
+
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH
+
+// Context bound to the calling thread, NULL for its own XCEP_g_Context
+extern XCEP_THREAD_LOCAL XCEP_t_Context* XCEP_g_CurrentContext XCEP___TLS_MODEL;
+
+// Returns the context bound to the calling thread, hot loops can cache it and use TryCtx/ThrowCtx
+XCEP___INLINE XCEP_t_Context* XCEP_GetContext(void) {
+	XCEP_t_Context* vContext = XCEP_g_CurrentContext;
+	return vContext != NULL ? vContext : &XCEP_g_Context;
+}
+
+// Empty context for a fiber, its frames, exceptions, defers and handler follow the fiber from thread to thread
+XCEP___INLINE void XCEP_ContextInit(XCEP_t_Context* outContext) {
+	memset(outContext, 0, sizeof(*outContext));
+}
+
+// Binds inContext to the calling thread, NULL goes back to the thread's own context. Returns the previous one.
+// A fiber scheduler binds the fiber context before resuming it on a carrier thread and restores it after.
+XCEP___INLINE XCEP_t_Context* XCEP_ContextBind(XCEP_t_Context* inContext) {
+	XCEP_t_Context* vPrevious = XCEP_g_CurrentContext;
+	XCEP_g_CurrentContext = inContext;
+	return vPrevious;
+}
+
+// Same, when the scheduler already knows the context it leaves (NULL is the thread's own)
+XCEP___INLINE void XCEP_ContextSwitch(XCEP_t_Context* inFrom, XCEP_t_Context* inTo) {
+	assert(XCEP_g_CurrentContext == inFrom && "XCEP_ContextSwitch must leave the context bound to the thread.");
+	(void)inFrom;
+	XCEP_g_CurrentContext = inTo;
+}
+
+#else
+
+// Returns the context of the calling thread, hot loops can cache it and use TryCtx/ThrowCtx
+XCEP___INLINE XCEP_t_Context* XCEP_GetContext(void) {
+	return &XCEP_g_Context;
+}
+
+#endif
+
+#define XCEP_g_Stack (XCEP_GetContext()->stack)
+#define XCEP_g_LastException (XCEP_GetContext()->last_exception)
 
 // =========================================================
 // MARK: UncaughtExceptionHandler
 // =========================================================
 
-extern XCEP_t_ExceptionHandler XCEP_g_UncaughtExceptionHandler;
-#define XCEP_SetUncaughtExceptionHandler(_handler) XCEP_g_UncaughtExceptionHandler = (_handler)
+// An uncaught exception first goes to every subscriber, then to the first handler set among: the thread handler,
+// the handler of its code, the global handler. Without any, it is printed and the process exits with its code.
+// Every registry update is an atomic swap or compare-and-swap, an invocation takes no lock. A handler replaced or
+// removed concurrently can still be called by an invocation that loaded it before the update.
+extern XCEP_t_ExceptionHandler volatile XCEP_g_UncaughtExceptionHandler;
+
+// Returns the previous handler, to chain to it
+XCEP_t_ExceptionHandler XCEP_SetUncaughtExceptionHandler(XCEP_t_ExceptionHandler inHandler);
+
+#if XCEP_CONF_HANDLER_SUBSCRIBERS
+// Subscribers observe every uncaught exception and must return. Returns 0, or -1 when every slot is taken.
+int XCEP_AddUncaughtExceptionHandler(XCEP_t_ExceptionHandler inHandler);
+// Removes one subscription of inHandler, returns XCEP_FALSE when there is none
+XCEP_t_Bool XCEP_RemoveUncaughtExceptionHandler(XCEP_t_ExceptionHandler inHandler);
+#endif
+
+#if XCEP_CONF_HANDLER_TABLE_SIZE
+// Handler of the uncaught exceptions of code inCode, NULL removes it. The previous one goes to outPrevious when
+// not NULL. Returns 0, or -1 when the table has no slot left for a new code.
+int XCEP_SetCodeUncaughtExceptionHandler(XCEP_t_Int inCode, XCEP_t_ExceptionHandler inHandler, XCEP_t_ExceptionHandler* outPrevious);
+XCEP_t_ExceptionHandler XCEP_GetCodeUncaughtExceptionHandler(XCEP_t_Int inCode);
+#endif
 
 #if XCEP_CONF_ENABLE_THREAD_SAFE
-	extern XCEP_THREAD_LOCAL XCEP_t_ExceptionHandler XCEP_g_ThreadUncaughtExceptionHandler;
+	#define XCEP_g_ThreadUncaughtExceptionHandler (XCEP_GetContext()->uncaught_handler)
 	#define XCEP_SetThreadUncaughtExceptionHandler(_handler) XCEP_g_ThreadUncaughtExceptionHandler = (_handler)
 	#define XCEP___IF_THREAD(_instruction) (_instruction)
 #else
@@ -133,130 +864,2271 @@ extern XCEP_t_ExceptionHandler XCEP_g_UncaughtExceptionHandler;
 #endif
 
 // =========================================================
-// MARK: Functions Def
+// MARK: Library Error Codes
 // =========================================================
 
-void XCEP___PrintException(const char* inFormat, const XCEP_t_Exception* inException);
-void XCEP___Thrown(const XCEP_t_Exception *inException);
-void XCEP___EndTry(const XCEP_t_Frame* inCurrentFrame);
-void XCEP___Rethrow(XCEP_t_Frame* inCurrentFrame);
+#define XCEP_ERR_DEFER_OVERFLOW ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 1))
+#define XCEP_ERR_TYPED ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 2))
+#define XCEP_ERR_CANCELLED ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 3))
+#define XCEP_ERR_TASKS_FAILED ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 4))
+#define XCEP_ERR_SEGFAULT ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 5))
+#define XCEP_ERR_BUS_ERROR ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 6))
+#define XCEP_ERR_FPE ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 7))
+#define XCEP_ERR_ILLEGAL_INSTRUCTION ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 8))
+#define XCEP_ERR_TRY_DEPTH ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 9))
+#define XCEP_ERR_TYPE_DEPTH ((XCEP_t_Int)(XCEP_CONF_ERROR_CODE_BASE - 10))
 
 // =========================================================
-// MARK: Exception Print
+// MARK: Functions Def
 // =========================================================
 
-#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
-#define XCEP_FormatException(_text) _text " (%d) caused by: \"%s\"\n\tat %s(%s:%d)\n"
-#else
-#define XCEP_FormatException(_text) _text " (%d) caused by: \"%s\"\n"
-#endif
+void XCEP___PrintException(const char* inFormat, const XCEP_t_Exception* inException);
+XCEP___THROWING void XCEP___Thrown(const XCEP_t_Exception *inException);
+XCEP___THROWING void XCEP___ThrownCtx(XCEP_t_Context* inContext, const XCEP_t_Exception *inException);
+void XCEP___EndTry(XCEP_t_Context* inContext, const XCEP_t_Frame* inCurrentFrame);
+void XCEP___Rethrow(XCEP_t_Frame* inCurrentFrame);
 
-#define XCEP_PrintException(_text, _exception) XCEP___PrintException(XCEP_FormatException(_text), _exception)
+// Copies the exception handled by the calling thread, message and payload included, call it from a Catch
+void XCEP_CaptureException(XCEP_t_ExceptionPtr* outCaptured);
+// Throws a captured exception in the calling thread, whichever thread captured it
+XCEP___THROWING void XCEP_RethrowCaptured(const XCEP_t_ExceptionPtr* inCaptured);
 
-// =========================================================
-// MARK: Syntax
-// =========================================================
+#if XCEP_CONF_CAUSE_DEPTH
+XCEP___THROWING void XCEP___ThrownWithCause(XCEP_t_Context* inContext, const XCEP_t_Exception* inException);
+#endif
 
-#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
-#define XCEP_NewException(_code, _msg) (XCEP_t_Exception){ .code = _code, .message = _msg, .line = __LINE__, .file = __FILE__, .function = __func__ }
-#else
-#define XCEP_NewException(_code, _msg) (XCEP_t_Exception){ .code = _code, .message = _msg }
+#if XCEP_CONF_ENABLE_STATS
+// Sums the counters of every site thrown at least once, without stopping the threads updating them.
+// Fills up to inCapacity entries of outStats and returns the number of sites, call again with more room if larger.
+size_t XCEP_StatsSnapshot(XCEP_t_SiteStats* outStats, size_t inCapacity);
 #endif
 
-#define XCEP__DECLARE_STATE_STRUCT \
-	struct { \
-		XCEP_t_Frame frame; \
-	} XCEP_v_state
+#if XCEP_CONF_ENABLE_LATENCY
+#include <stdio.h>
+// Buckets of the histograms: values below 8 are exact, then 4 buckets per power of two ([8, 10), [10, 12)...).
+// Latencies from 2^40 ticks and hops from 2^12 are counted in the last bucket.
+#define XCEP_LATENCY_BUCKETS 156
+#define XCEP_HOPS_BUCKETS 44
 
-#define XCEP_Try \
-	for ( \
-		XCEP__DECLARE_STATE_STRUCT = { 0 }; /*Init*/ \
-		XCEP_v_state.frame.state_flags.run_once == XCEP_FALSE; /*Cond*/ \
-		XCEP_v_state.frame.state_flags.run_once = XCEP_TRUE, XCEP___EndTry((XCEP_t_Frame*)&XCEP_v_state.frame) /*Cleanup*/ \
-	) \
-	do { \
-		if ( (XCEP_v_state.frame.prev = XCEP_g_Stack, \
-			  XCEP_g_Stack = (XCEP_t_Frame*)&XCEP_v_state.frame, \
-			  XCEP_v_state.frame.state_flags.thrown = setjmp(XCEP_v_state.frame.env) ) == XCEP_FALSE )
+typedef struct {
+	XCEP_t_Int code;
+	XCEP_t_Bool overflow; // Histogram of the codes caught once every code slot was taken, code is 0
+	long long count;
+	long long latency[XCEP_LATENCY_BUCKETS];
+	long long hops[XCEP_HOPS_BUCKETS];
+} XCEP_t_LatencyHistogram;
 
-#define XCEP_Catch(_code) \
-	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP_g_LastException.code == (_code) && (XCEP_v_state.frame.state_flags.have_been_handled = XCEP_TRUE)) \
+// Merges the shards of every code caught at least once, without stopping the threads updating them.
+// Fills up to inCapacity entries of outHistograms and returns the number of codes, call again with more room if larger.
+size_t XCEP_LatencySnapshot(XCEP_t_LatencyHistogram* outHistograms, size_t inCapacity);
+// Adds the counts of inFrom to ioInto, ex: one histogram for several codes or snapshots
+void XCEP_LatencyMerge(XCEP_t_LatencyHistogram* ioInto, const XCEP_t_LatencyHistogram* inFrom);
+// Smallest value counted in a bucket
+unsigned long long XCEP_LatencyBucketLow(XCEP_t_Uint inBucket);
+// Smallest value of the bucket holding the inQuantile (0 to 1) sample, 0 for an empty histogram
+unsigned long long XCEP_LatencyPercentile(const long long* inBuckets, XCEP_t_Uint inBucketCount, double inQuantile);
+// Ticks per second, rdtsc is measured against the monotonic clock for a few milliseconds on the first call
+long long XCEP_LatencyTickRate(void);
+// One line per code: caught count, latency percentiles in ns and hop percentiles
+void XCEP_LatencyDump(FILE* inOutput);
 
-#define XCEP_CatchAll \
-	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && (XCEP_v_state.frame.state_flags.have_been_handled = XCEP_TRUE)) \
+void XCEP___LatencyCaught(XCEP_t_Context* inContext);
+#endif
 
-#define XCEP_CaughtException XCEP_g_LastException
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+// Creates or truncates inPath and maps it as the recorder of the process. Returns 0, or -1 with errno set.
+// Open it before the threads to record start throwing and close it after, not while they run.
+int XCEP_RecorderOpen(const char* inPath);
+// Unmaps the file, everything recorded stays in it
+void XCEP_RecorderClose(void);
 
-#define XCEP_Finally if (1)
+void XCEP___RecorderAppend(XCEP_t_Context* inContext, XCEP_t_Uint inKind, const XCEP_t_Exception* inException);
+#endif
 
-#define XCEP_EndTry \
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+#include <stdio.h>
+// Starts the thread writing the log records to inOutput (stderr when NULL) in batches, returns 0 on success
+int XCEP_LogStart(FILE* inOutput);
+// Writes every record pushed before the call, from the drainer thread or from the caller when it is not started
+void XCEP_LogFlush(void);
+// Flushes and stops the drainer thread
+void XCEP_LogStop(void);
+// Records dropped because the ring was full
+long long XCEP_LogDropped(void);
+#endif
+
+#if XCEP_CONF_ENABLE_SIGNALS
+// Installs the SIGSEGV, SIGBUS, SIGFPE and SIGILL handlers and the alternate stack of the calling thread, returns 0 on success.
+// A fault with no Try active on the thread goes to the handler found at install time, or gets the default action.
+int XCEP_SignalsInstall(void);
+// Maps the alternate stack of the calling thread, released when it exits. Done by XCEP_ThreadStart and the task
+// group workers themselves, calling it again does nothing.
+int XCEP_SignalsThreadInit(void);
+// Puts back the handlers found by XCEP_SignalsInstall
+void XCEP_SignalsUninstall(void);
+#endif
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+// Captures 1 throw in inRate from now on, on every thread, 0 stops the capture
+void XCEP_SetBacktraceSampling(XCEP_t_Uint inRate);
+// Symbolizes and prints to stderr the backtrace of the last throw of the calling thread, if captured
+void XCEP_PrintBacktrace(void);
+#endif
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+// Formats into the message arena of inContext, the result is valid until the arena wraps around to its slot
+// and while a Catch handles it. inFormat itself comes back, unformatted, when every slot is pinned.
+const char* XCEP___FormatMessage(XCEP_t_Context* inContext, const char* inFormat, ...) XCEP___PRINTF_FORMAT(2, 3);
+
+// inDelta more Catch blocks handle inMessage, its slot is skipped while pinned. Messages out of the arena are ignored.
+XCEP___INLINE void XCEP___PinMessage(XCEP_t_Context* inContext, const char* inMessage, int inDelta) {
+	if (inMessage == NULL) return;
+	const size_t vOffset = (size_t)(inMessage - inContext->message_arena);
+	if (vOffset < (size_t)XCEP___MESSAGE_SLOTS * XCEP_CONF_MESSAGE_MAX_SIZE) {
+		inContext->message_pins[vOffset / XCEP_CONF_MESSAGE_MAX_SIZE] += inDelta;
+	}
+}
+#endif
+
+#if XCEP_CONF_ENABLE_DEFER
+void XCEP___DeferUnwind(XCEP_t_Context* inContext, XCEP_t_Uint inMark);
+XCEP___THROWING void XCEP___DeferOverflow(XCEP_t_Context* inContext, XCEP_t_DeferFunc inFunc, void* inArg);
+#endif
+
+// =========================================================
+// MARK: Threads
+// =========================================================
+
+#if XCEP_CONF_ENABLE_THREAD_API || XCEP_CONF_ENABLE_ASYNC_LOG
+	#if defined(_WIN32)
+		typedef void* XCEP___t_NativeThread; // HANDLE, without including Windows.h here
+		typedef void* XCEP___t_NativeLock;   // SRWLOCK, a single pointer as well
+		typedef void* XCEP___t_NativeCond;   // CONDITION_VARIABLE
+	#else
+		#include <pthread.h>
+		typedef pthread_t XCEP___t_NativeThread;
+		typedef pthread_mutex_t XCEP___t_NativeLock;
+		typedef pthread_cond_t XCEP___t_NativeCond;
+	#endif
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API
+
+typedef void (*XCEP_t_ThreadFunc)(void* inArg);
+
+// Must stay at the same address from XCEP_ThreadStart to XCEP_ThreadJoin
+typedef struct {
+	XCEP___t_NativeThread native;
+	XCEP_t_ThreadFunc func;
+	void* arg;
+	XCEP_t_ExceptionPtr exception; // Exception escaping func, if any
+} XCEP_t_Thread;
+
+// Runs inFunc(inArg) on a new thread inside a Try, returns 0 on success
+int XCEP_ThreadStart(XCEP_t_Thread* outThread, XCEP_t_ThreadFunc inFunc, void* inArg);
+// Waits for the thread and rethrows in the caller the exception that escaped its function
+void XCEP_ThreadJoin(XCEP_t_Thread* inThread);
+
+// =========================================================
+// MARK: Task Groups
+// =========================================================
+
+typedef void (*XCEP_t_TaskFunc)(void* inArg);
+typedef void (*XCEP_t_IndexFunc)(long inIndex, void* inArg);
+
+// What XCEP_TaskGroupWait throws when tasks failed:
+// - XCEP_TASK_RETHROW_FIRST: the first exception, it also cancels the group
+// - XCEP_TASK_RETHROW_ALL: XCEP_ERR_TASKS_FAILED once every task ran, the exceptions are in `errors`
+typedef enum {
+	XCEP_TASK_RETHROW_FIRST,
+	XCEP_TASK_RETHROW_ALL
+} XCEP_t_TaskRethrow;
+
+// func(arg), or body(i, arg) for i in [begin, end) when body is set
+typedef struct {
+	XCEP_t_TaskFunc func;
+	XCEP_t_IndexFunc body;
+	void* arg;
+	long begin;
+	long end;
+	long grain;
+	volatile long* scope; // Unfinished tasks of the task that ran this one, NULL when run from outside the group
+} XCEP___t_Task;
+
+// Chase-Lev deque: its worker pushes and pops at bottom, the other workers steal at top
+typedef struct {
+	volatile long top;
+	volatile long bottom;
+	XCEP___t_Task tasks[XCEP_CONF_TASK_QUEUE_SIZE];
+} XCEP___t_TaskDeque;
+
+typedef struct {
+	struct XCEP_t_TaskGroup* group;
+	int index;
+} XCEP___t_TaskWorker;
+
+// Fixed pool of workers, each with its own Try context. Worker 0 is the thread calling XCEP_TaskGroupWait.
+// Must stay at the same address from XCEP_TaskGroupInit to XCEP_TaskGroupDestroy.
+typedef struct XCEP_t_TaskGroup {
+	XCEP_t_TaskRethrow rethrow;
+	int worker_count;
+	volatile long running;
+	volatile long pending;     // Tasks pushed and not finished
+	volatile long cancelled;
+	volatile long error_count; // Exceptions caught at the task boundary, XCEP_ERR_CANCELLED excluded
+	long failed;               // error_count of the last XCEP_TaskGroupWait, errors holds the first ones
+	volatile long sleepers;    // Workers blocked on wake, a push only takes the lock when there are some
+	XCEP___t_NativeLock lock;
+	XCEP___t_NativeCond wake;  // Signaled by a push, broadcast once nothing is pending and by XCEP_TaskGroupDestroy
+	XCEP_t_ExceptionPtr errors[XCEP_CONF_TASK_MAX_ERRORS];
+	XCEP___t_NativeThread threads[XCEP_CONF_TASK_MAX_WORKERS];
+	XCEP___t_TaskWorker workers[XCEP_CONF_TASK_MAX_WORKERS];
+	XCEP___t_TaskDeque deques[XCEP_CONF_TASK_MAX_WORKERS];
+} XCEP_t_TaskGroup;
+
+// Starts inWorkers - 1 threads (clamped to [1, XCEP_CONF_TASK_MAX_WORKERS]), returns 0 on success
+int XCEP_TaskGroupInit(XCEP_t_TaskGroup* outGroup, int inWorkers, XCEP_t_TaskRethrow inRethrow);
+// Queues inFunc(inArg), call it from the thread waiting for the group or from one of its tasks.
+// A task does not end before the tasks it queued, it runs queued tasks meanwhile.
+void XCEP_TaskGroupRun(XCEP_t_TaskGroup* inGroup, XCEP_t_TaskFunc inFunc, void* inArg);
+// Runs tasks with the other workers until all are done, then throws as configured by the group rethrow mode.
+// From one of its tasks, it only waits for the tasks queued by that task and throws XCEP_ERR_CANCELLED once the
+// group is cancelled: their exceptions are thrown by the outermost XCEP_TaskGroupWait.
+void XCEP_TaskGroupWait(XCEP_t_TaskGroup* inGroup);
+// Queued tasks are skipped, running ones stop at their next XCEP_CheckCancel
+void XCEP_TaskGroupCancel(XCEP_t_TaskGroup* inGroup);
+// Stops and joins the workers, the group must not have pending tasks
+void XCEP_TaskGroupDestroy(XCEP_t_TaskGroup* inGroup);
+// inBody(i, inArg) for i in [inBegin, inEnd), split in halves down to inGrain indices, then XCEP_TaskGroupWait
+void XCEP_ParallelFor(XCEP_t_TaskGroup* inGroup, long inBegin, long inEnd, long inGrain, XCEP_t_IndexFunc inBody, void* inArg);
+// Throws XCEP_ERR_CANCELLED in a task of a cancelled group, does nothing elsewhere
+void XCEP_CheckCancel(void);
+
+#endif
+
+// =========================================================
+// MARK: Defer
+// =========================================================
+
+#if XCEP_CONF_ENABLE_DEFER
+
+// Pushes a cleanup run when a Throw unwinds past it or when the enclosing Try ends, on overflow
+// the cleanup is run right away and XCEP_ERR_DEFER_OVERFLOW is thrown
+XCEP___INLINE void XCEP___Defer(XCEP_t_Context* inContext, const XCEP_t_DeferFunc inFunc, void* inArg) {
+	if (inContext->defer_top < XCEP_CONF_DEFER_STACK_SIZE) {
+		XCEP_t_Deferred* vEntry = &inContext->defer_stack[inContext->defer_top++];
+		vEntry->func = inFunc;
+		vEntry->arg = inArg;
+		return;
+	}
+	XCEP___DeferOverflow(inContext, inFunc, inArg);
+}
+
+// Pops the last cleanup and runs it, the normal path release of the last deferred resource
+XCEP___INLINE void XCEP___DeferRelease(XCEP_t_Context* inContext) {
+	assert(inContext->defer_top > 0 && "DeferRelease without a matching Defer.");
+	const XCEP_t_Deferred vEntry = inContext->defer_stack[--inContext->defer_top];
+	vEntry.func(vEntry.arg);
+}
+
+// Pops the last cleanup without running it, ex: the resource ownership has been handed over
+XCEP___INLINE void XCEP___DeferCancel(XCEP_t_Context* inContext) {
+	assert(inContext->defer_top > 0 && "DeferCancel without a matching Defer.");
+	--inContext->defer_top;
+}
+
+#define XCEP_Defer(_func, _arg) XCEP___Defer(XCEP_GetContext(), (XCEP_t_DeferFunc)(_func), (void*)(_arg))
+#define XCEP_DeferRelease() XCEP___DeferRelease(XCEP_GetContext())
+#define XCEP_DeferCancel() XCEP___DeferCancel(XCEP_GetContext())
+
+#define XCEP___DEFER_MARK(_state) (_state).frame.defer_mark = (_state).ctx->defer_top,
+
+#else
+
+#define XCEP___DEFER_MARK(_state)
+
+#endif
+
+// =========================================================
+// MARK: Exception Types
+// =========================================================
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+
+#define XCEP___TYPE_UNRESOLVED 0
+#define XCEP___TYPE_RESOLVING 1
+#define XCEP___TYPE_RESOLVED 2
+
+#define XCEP_TYPE(_name) (&XCEP_TYPE_##_name)
+
+// XCEP_DECLARE_TYPE goes in headers, XCEP_DEFINE_TYPE in exactly one source file
+#define XCEP_DECLARE_TYPE(_name) extern XCEP_t_Type XCEP_TYPE_##_name
+#define XCEP_DEFINE_TYPE_CODE(_name, _parent, _code) \
+	XCEP_t_Type XCEP_TYPE_##_name = { .name = #_name, .parent = XCEP_TYPE(_parent), .code = (_code) }
+#define XCEP_DEFINE_TYPE(_name, _parent) XCEP_DEFINE_TYPE_CODE(_name, _parent, XCEP_ERR_TYPED)
+
+// Root of every hierarchy, plain integer code exceptions are of this type
+XCEP_DECLARE_TYPE(Exception);
+
+void XCEP___ResolveType(XCEP_t_Type* inType);
+
+XCEP___INLINE XCEP_t_Bool XCEP___IsInstanceOf(const XCEP_t_Exception* inException, const XCEP_t_Type* inType) {
+	const XCEP_t_Type* vType = inException->type ? inException->type : XCEP_TYPE(Exception);
+
+	// A type never thrown is not resolved yet, it cannot be an ancestor of a thrown one
+	return XCEP___AtomicLoad(&inType->state) == XCEP___TYPE_RESOLVED
+		&& inType->depth <= vType->depth
+		&& vType->display[inType->depth] == inType;
+}
+
+#define XCEP_IsInstanceOf(_exception, _name) XCEP___IsInstanceOf((_exception), XCEP_TYPE(_name))
+
+#endif
+
+// =========================================================
+// MARK: Catch Dispatch
+// =========================================================
+
+// Packed compares need 32 bits codes, custom XCEP_t_Int types use the scalar loop
+#if XCEP_CONF_ENABLE_SIMD_DISPATCH && !XCEP_CONF_ENABLE_CUSTOM_TYPES
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <emmintrin.h>
+		#define XCEP___SIMD_SSE2 1
+	#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+		#include <arm_neon.h>
+		#define XCEP___SIMD_NEON 1
+	#endif
+#endif
+
+// Is inCode one of the inCount codes of inCodes. No early exit in the packed loop: the whole list
+// is usually a few vectors and a single final test is cheaper than a branch per vector.
+XCEP___INLINE XCEP_t_Bool XCEP___CodeIn(const XCEP_t_Int inCode, const XCEP_t_Int* inCodes, const size_t inCount) {
+	size_t i = 0;
+#if defined(XCEP___SIMD_SSE2)
+	const __m128i vNeedle = _mm_set1_epi32(inCode);
+	__m128i vHits = _mm_setzero_si128();
+	for (; i + 4 <= inCount; i += 4) {
+		vHits = _mm_or_si128(vHits, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(inCodes + i)), vNeedle));
+	}
+	if (_mm_movemask_epi8(vHits) != 0) return XCEP_TRUE;
+#elif defined(XCEP___SIMD_NEON)
+	const int32x4_t vNeedle = vdupq_n_s32(inCode);
+	uint32x4_t vHits = vdupq_n_u32(0);
+	for (; i + 4 <= inCount; i += 4) {
+		vHits = vorrq_u32(vHits, vceqq_s32(vld1q_s32(inCodes + i), vNeedle));
+	}
+	if (vmaxvq_u32(vHits) != 0) return XCEP_TRUE;
+#endif
+	for (; i < inCount; ++i) {
+		if (inCodes[i] == inCode) return XCEP_TRUE;
+	}
+	return XCEP_FALSE;
+}
+
+// =========================================================
+// MARK: Exception Print
+// =========================================================
+
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+#define XCEP_FormatException(_text) _text " (%d) caused by: \"%s\"\n\tat %s(%s:%d)\n"
+#else
+#define XCEP_FormatException(_text) _text " (%d) caused by: \"%s\"\n"
+#endif
+
+#define XCEP_PrintException(_text, _exception) XCEP___PrintException(XCEP_FormatException(_text), _exception)
+
+// =========================================================
+// MARK: Cause Chains
+// =========================================================
+
+#if XCEP_CONF_CAUSE_DEPTH
+// Walks the causes of the last exception thrown in the calling thread, the one a Catch is handling.
+// The direct cause comes first, then its own cause, and so on.
+typedef struct {
+	const XCEP_t_Context* ctx;
+	XCEP_t_Uint next;
+} XCEP_t_CauseIterator;
+
+XCEP___INLINE void XCEP_CauseBegin(XCEP_t_CauseIterator* outIterator) {
+	outIterator->ctx = XCEP_GetContext();
+	outIterator->next = 0;
+}
+
+// NULL after the oldest cause kept
+XCEP___INLINE const XCEP_t_Exception* XCEP_CauseNext(XCEP_t_CauseIterator* ioIterator) {
+	const XCEP_t_Context* vContext = ioIterator->ctx;
+	if (ioIterator->next >= vContext->cause_length) return NULL;
+	const XCEP_t_Uint vSlot = (vContext->cause_top + XCEP_CONF_CAUSE_DEPTH - 1 - ioIterator->next++) % XCEP_CONF_CAUSE_DEPTH;
+	return &vContext->causes[vSlot].exception;
+}
+
+XCEP___INLINE XCEP_t_Uint XCEP_CauseCount(void) {
+	return XCEP_GetContext()->cause_length;
+}
+
+// Where the chain of the exception a Catch takes is, causes thrown in the Catch are written after it
+XCEP___INLINE void XCEP___CauseMark(const XCEP_t_Context* inContext, XCEP_t_Frame* outFrame) {
+	const XCEP_t_Bool vOwner = inContext->cause_code == outFrame->handled.code && inContext->cause_message == outFrame->handled.message;
+	outFrame->cause_mark = inContext->cause_count;
+	outFrame->cause_chain = vOwner ? inContext->cause_length : 0;
+}
+#endif
+
+// =========================================================
+// MARK: Syntax
+// =========================================================
+
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+// Bounds of the section, defined by the linker in every module having at least one record
+extern const XCEP_t_SiteRecord __start_xcep_sites[] __attribute__((weak, visibility("hidden")));
+extern const XCEP_t_SiteRecord __stop_xcep_sites[] __attribute__((weak, visibility("hidden")));
+
+// Records are pointer aligned and a whole number of pointers in size, so the linker packs the records of every
+// translation unit as one array. Statement expression: the record is a static local of the throwing function.
+#define XCEP___SITE_ID() \
+	__extension__ ({ \
+		static const XCEP_t_SiteRecord XCEP_v_site_record \
+			__attribute__((section("xcep_sites"), used, aligned(sizeof(void*)))) = { __FILE__, __func__, __LINE__ }; \
+		(XCEP_t_Uint)(&XCEP_v_site_record - __start_xcep_sites) + 1; \
+	})
+#define XCEP___SITE_INFO .site_id = XCEP___SITE_ID(),
+
+// NULL for 0 or an id past the records of this module. Ids are only meaningful in the module that produced
+// them: an id thrown by another module and in range returns an unrelated record of this one.
+XCEP___INLINE const XCEP_t_SiteRecord* XCEP_SiteLookup(const XCEP_t_Uint inSiteId) {
+	if (inSiteId == 0 || inSiteId > (XCEP_t_Uint)(__stop_xcep_sites - __start_xcep_sites)) return NULL;
+	return &__start_xcep_sites[inSiteId - 1];
+}
+
+XCEP___INLINE XCEP_t_Uint XCEP_SiteCount(void) {
+	return (XCEP_t_Uint)(__stop_xcep_sites - __start_xcep_sites);
+}
+#elif XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+#define XCEP___SITE_INFO .line = __LINE__, .file = __FILE__, .function = __func__,
+#else
+#define XCEP___SITE_INFO
+#endif
+
+// Extra designated initializers can be given after the message, ex: .type = XCEP_TYPE(IoError)
+#define XCEP___NewException(_code, _msg, ...) (XCEP_t_Exception){ .code = _code, .message = _msg, XCEP___SITE_INFO __VA_ARGS__ }
+#define XCEP_NewException(_code, _msg) XCEP___NewException(_code, _msg, )
+
+// =========================================================
+// MARK: Try Depth
+// =========================================================
+
+// Stack bytes of one Try: its frame and the context pointer stored next to it
+#define XCEP_TRY_FRAME_SIZE (sizeof(XCEP_t_Frame) + sizeof(XCEP_t_Context*))
+
+#if XCEP___TRACK_DEPTH
+
+typedef struct {
+	XCEP_t_Uint depth;
+	XCEP_t_Uint max_depth;
+	size_t frame_bytes;     // depth * XCEP_TRY_FRAME_SIZE
+	size_t max_frame_bytes;
+} XCEP_t_TryDepth;
+
+void XCEP___DepthRaise(XCEP_t_Context* inContext);
+
+// Counts the Try being entered, before its frame is pushed
+XCEP___INLINE void XCEP___DepthEnter(XCEP_t_Context* inContext) {
+	if (XCEP___UNLIKELY(++inContext->try_depth > inContext->try_depth_max)) XCEP___DepthRaise(inContext);
+}
+
+// Depth counters of the context bound to the calling thread
+XCEP___INLINE void XCEP_GetTryDepth(XCEP_t_TryDepth* outDepth) {
+	const XCEP_t_Context* vContext = XCEP_GetContext();
+	outDepth->depth = vContext->try_depth;
+	outDepth->max_depth = vContext->try_depth_max;
+	outDepth->frame_bytes = vContext->try_depth * XCEP_TRY_FRAME_SIZE;
+	outDepth->max_frame_bytes = vContext->try_depth_max * XCEP_TRY_FRAME_SIZE;
+}
+
+#define XCEP___DEPTH_ENTER(_state) XCEP___DepthEnter((_state).ctx),
+
+#else
+
+#define XCEP___DEPTH_ENTER(_state)
+
+#endif
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS
+typedef struct {
+	XCEP_t_Uint max_depth;  // Deepest nesting reached by any context
+	size_t max_frame_bytes;
+	long long contexts;     // Contexts that entered at least one Try
+	long long limit_hits;   // XCEP_ERR_TRY_DEPTH thrown
+} XCEP_t_TryDepthStats;
+
+// A few relaxed loads, a metrics thread can poll it as often as it likes
+void XCEP_TryDepthSnapshot(XCEP_t_TryDepthStats* outStats);
+#endif
+
+#define XCEP__DECLARE_STATE_STRUCT \
+	struct { \
+		XCEP_t_Frame frame; \
+		XCEP_t_Context* ctx; \
+	} XCEP_v_state
+
+#if XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_UNWIND
+// The cleanup of XCEP_v_guard is the landing pad of every call in the Try block. It runs on normal exits too,
+// only the frame targeted by the unwind jumps back (non-local goto) to re-evaluate the Try condition.
+#define XCEP___TRY_LANDING_PAD \
+		__label__ XCEP_l_landing; \
+		void XCEP_v_land(int* inGuard) { \
+			(void)inGuard; \
+			if (XCEP_v_state.frame.env.pending) { \
+				XCEP_v_state.frame.env.pending = XCEP_FALSE; \
+				XCEP_v_state.frame.env.landed = XCEP_TRUE; \
+				goto XCEP_l_landing; \
+			} \
+		} \
+		int XCEP_v_guard __attribute__((cleanup(XCEP_v_land))) = 0; \
+		(void)XCEP_v_guard; \
+		XCEP_l_landing:
+// Landing again after a throw in a Catch: the frame is still on the stack, only thrown is set
+#define XCEP___TRY_ENTER(_state) \
+	((_state).frame.env.landed \
+		? ((_state).frame.state_flags.thrown = XCEP_TRUE) \
+		: (XCEP___DEPTH_ENTER(_state) \
+		   (_state).frame.prev = (_state).ctx->stack, \
+		   XCEP___DEFER_MARK(_state) \
+		   (_state).ctx->stack = (XCEP_t_Frame*)&(_state).frame, \
+		   (_state).frame.state_flags.thrown = XCEP_FALSE))
+#else
+#define XCEP___TRY_LANDING_PAD
+#define XCEP___TRY_ENTER(_state) \
+	(XCEP___DEPTH_ENTER(_state) \
+	 (_state).frame.prev = (_state).ctx->stack, \
+	 XCEP___DEFER_MARK(_state) \
+	 (_state).ctx->stack = (XCEP_t_Frame*)&(_state).frame, \
+	 (_state).frame.state_flags.thrown = XCEP___SetJmp((_state).frame.env))
+#endif
+
+// Opens a Try whose state is initialized with the designators given
+#define XCEP___TRY(...) \
+	for ( \
+		XCEP__DECLARE_STATE_STRUCT = { __VA_ARGS__ }; /*Init*/ \
+		XCEP_v_state.frame.state_flags.run_once == XCEP_FALSE; /*Cond*/ \
+		XCEP_v_state.frame.state_flags.run_once = XCEP_TRUE, XCEP___EndTry(XCEP_v_state.ctx, (XCEP_t_Frame*)&XCEP_v_state.frame) /*Cleanup*/ \
+	) \
+	do { \
+		XCEP___TRY_LANDING_PAD \
+		if ( XCEP___TRY_ENTER(XCEP_v_state) == XCEP_FALSE )
+
+#define XCEP_TryCtx(_ctx) XCEP___TRY(.ctx = (_ctx))
+#define XCEP_Try XCEP_TryCtx(XCEP_GetContext())
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+// Try landed in only for the exceptions _filter (const XCEP_t_Filter*) accepts, the others skip it. Its Catch
+// clauses must take what the filter accepts, cleanups go in Defer: it has no Finally, a throw passing over never runs it.
+// The filter must live as long as the Try, XCEP_FilterCodes/Range/When build it in the enclosing block.
+#define XCEP_TryFilterCtx(_ctx, _filter) XCEP___TRY(.frame.filter = (_filter), .ctx = (_ctx))
+#define XCEP_TryFilter(_filter) XCEP_TryFilterCtx(XCEP_GetContext(), _filter)
+
+#define XCEP_FilterCodes(...) \
+	(&(const XCEP_t_Filter){ .codes = (const XCEP_t_Int[]){ __VA_ARGS__ }, \
+		.code_count = sizeof((const XCEP_t_Int[]){ __VA_ARGS__ }) / sizeof(XCEP_t_Int) })
+#define XCEP_FilterRange(_low, _high) (&(const XCEP_t_Filter){ .has_range = XCEP_TRUE, .low = (_low), .high = (_high) })
+#define XCEP_FilterWhen(_predicate) (&(const XCEP_t_Filter){ .when = (_predicate) })
+#endif
+
+// The Catch taking the exception records its latency and hops, and its flight recorder event first
+#if XCEP_CONF_ENABLE_LATENCY
+#define XCEP___CAUGHT_LATENCY(_state) XCEP___LatencyCaught((_state).ctx),
+#else
+#define XCEP___CAUGHT_LATENCY(_state)
+#endif
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+#define XCEP___CAUGHT_RECORD(_state) XCEP___RecorderAppend((_state).ctx, XCEP_RECORD_CATCH, &(_state).ctx->last_exception),
+#else
+#define XCEP___CAUGHT_RECORD(_state)
+#endif
+// Its formatted message stays in the arena until the Try ends
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+#define XCEP___CAUGHT_PIN(_state) XCEP___PinMessage((_state).ctx, (_state).frame.handled.message, 1),
+#else
+#define XCEP___CAUGHT_PIN(_state)
+#endif
+#if XCEP_CONF_CAUSE_DEPTH
+#define XCEP___CAUGHT_CAUSES(_state) XCEP___CauseMark((_state).ctx, &(_state).frame),
+#else
+#define XCEP___CAUGHT_CAUSES(_state)
+#endif
+#define XCEP___HANDLED(_state) \
+	(XCEP___CAUGHT_LATENCY(_state) XCEP___CAUGHT_RECORD(_state) \
+	 (_state).frame.handled = (_state).ctx->last_exception, XCEP___CAUGHT_PIN(_state) XCEP___CAUGHT_CAUSES(_state) \
+	 (_state).frame.state_flags.have_been_handled = XCEP_TRUE)
+
+#define XCEP_Catch(_code) \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP_v_state.ctx->last_exception.code == (_code) && XCEP___HANDLED(XCEP_v_state)) \
+
+// One clause for a list of codes, a single packed compare instead of one branch per code
+#define XCEP_CatchAny(...) \
+	XCEP_CatchIn(((const XCEP_t_Int[]){ __VA_ARGS__ }), sizeof((const XCEP_t_Int[]){ __VA_ARGS__ }) / sizeof(XCEP_t_Int))
+
+// Same with an existing array, ex: a `static const XCEP_t_Int` table shared by several Try
+#define XCEP_CatchIn(_codes, _count) \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP___CodeIn(XCEP_v_state.ctx->last_exception.code, (_codes), (_count)) && XCEP___HANDLED(XCEP_v_state)) \
+
+// Codes from _low to _high, both included
+#define XCEP_CatchRange(_low, _high) \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP_v_state.ctx->last_exception.code >= (_low) && XCEP_v_state.ctx->last_exception.code <= (_high) && XCEP___HANDLED(XCEP_v_state)) \
+
+// Exceptions _predicate (XCEP_t_ExceptionPredicate) accepts
+#define XCEP_CatchWhen(_predicate) \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && (_predicate)(&XCEP_v_state.ctx->last_exception) && XCEP___HANDLED(XCEP_v_state)) \
+
+#define XCEP_CatchAll \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP___HANDLED(XCEP_v_state)) \
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+#define XCEP_CatchType(_name) \
+	else if (XCEP_v_state.frame.state_flags.have_been_handled == XCEP_FALSE && XCEP___IsInstanceOf(&XCEP_v_state.ctx->last_exception, XCEP_TYPE(_name)) && XCEP___HANDLED(XCEP_v_state)) \
+
+#endif
+
+#define XCEP_CaughtException (XCEP_v_state.ctx->last_exception)
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+#define XCEP_Finally if ((assert(XCEP_v_state.frame.filter == NULL && "A TryFilter cannot have a Finally, use Defer."), 1))
+#else
+#define XCEP_Finally if (1)
+#endif
+
+#define XCEP_EndTry \
+	} while (0)
+
+#if XCEP_CONF_ENABLE_STATS
+// Every Throw expansion owns a static site descriptor. Statement expression: Throw stays a void expression,
+// ex: `ok ? (void)0 : Throw(...)`. MSVC has none, its throws become statements.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define XCEP___AT_SITE(_throw) \
+	do { \
+		static XCEP_t_ThrowSite XCEP_v_site = { .file = __FILE__, .function = __func__, .line = __LINE__ }; \
+		_throw; \
+	} while (0)
+#else
+#define XCEP___AT_SITE(_throw) \
+	__extension__ ({ \
+		static XCEP_t_ThrowSite XCEP_v_site = { .file = __FILE__, .function = __func__, .line = __LINE__ }; \
+		_throw; \
+	})
+#endif
+#define XCEP___SITE .site = &XCEP_v_site,
+#else
+#define XCEP___AT_SITE(_throw) _throw
+#define XCEP___SITE
+#endif
+
+#define XCEP_Throw(_code, _msg) XCEP___AT_SITE(XCEP___Thrown(&XCEP___NewException(_code, _msg, XCEP___SITE)))
+#define XCEP_ThrowCtx(_ctx, _code, _msg) XCEP___AT_SITE(XCEP___ThrownCtx((_ctx), &XCEP___NewException(_code, _msg, XCEP___SITE)))
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+#define XCEP_FormatMessage(...) XCEP___FormatMessage(XCEP_GetContext(), __VA_ARGS__)
+// Message formatted printf-like in the per-thread arena, no heap allocation
+#define XCEP_ThrowF(_code, ...) XCEP___AT_SITE(XCEP___Thrown(&XCEP___NewException(_code, XCEP_FormatMessage(__VA_ARGS__), XCEP___SITE)))
+#endif
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+#define XCEP_NewTypedException(_name, _msg) XCEP___NewException(XCEP_TYPE(_name)->code, _msg, .type = XCEP_TYPE(_name))
+#define XCEP_ThrowType(_name, _msg) \
+	XCEP___AT_SITE(XCEP___Thrown(&XCEP___NewException(XCEP_TYPE(_name)->code, _msg, .type = XCEP_TYPE(_name), XCEP___SITE)))
+#endif
+
+#if XCEP_CONF_PAYLOAD_SIZE
+// Compile error (negative array size) when the payload does not fit the per-thread buffer
+#define XCEP___PAYLOAD_SIZE(_type_or_expr) \
+	(sizeof(_type_or_expr) + 0 * sizeof(char[sizeof(_type_or_expr) <= XCEP_CONF_PAYLOAD_SIZE ? 1 : -1]))
+
+XCEP___INLINE const XCEP_t_Exception* XCEP___WithPayload(XCEP_t_Context* inContext, const XCEP_t_Exception* inException, const void* inPayload) {
+	memcpy(inContext->payload.bytes, inPayload, inException->payload_size);
+	return inException;
+}
+
+XCEP___INLINE const void* XCEP___CaughtPayload(const XCEP_t_Context* inContext, const size_t inSize) {
+	return inContext->last_exception.payload_size == inSize ? inContext->payload.bytes : NULL;
+}
+
+// Copies the POD lvalue _payload (a variable, a compound literal...) next to the thrown exception
+#define XCEP_ThrowWith(_code, _msg, _payload) \
+	XCEP___AT_SITE(XCEP___Thrown(XCEP___WithPayload(XCEP_GetContext(), \
+		&XCEP___NewException(_code, _msg, .payload_size = (XCEP_t_Uint)XCEP___PAYLOAD_SIZE(_payload), XCEP___SITE), &(_payload))))
+
+// Typed pointer to the payload of the caught exception, NULL when it was thrown without one of this size
+#define XCEP_CaughtPayload(_type) ((const _type*)XCEP___CaughtPayload(XCEP_v_state.ctx, XCEP___PAYLOAD_SIZE(_type)))
+#endif
+
+#if XCEP_CONF_CAUSE_DEPTH
+// Throws an exception caused by the one being handled, its chain follows. Outside a Catch it is a plain Throw.
+#define XCEP_ThrowWithCause(_code, _msg) \
+	XCEP___AT_SITE(XCEP___ThrownWithCause(XCEP_GetContext(), &XCEP___NewException(_code, _msg, XCEP___SITE)))
+#endif
+
+#define XCEP_Rethrow XCEP___Rethrow((XCEP_t_Frame*)&XCEP_v_state.frame)
+
+// =========================================================
+// MARK: Results
+// =========================================================
+
+// Expected failures returned by value instead of thrown, code 0 is success. Fits in two registers on common ABIs.
+typedef struct {
+	XCEP_t_Int code;
+	const char* message;
+} XCEP_t_Result;
+
+#define XCEP_Ok() ((XCEP_t_Result){ 0, NULL })
+#define XCEP_Fail(_code, _msg) ((XCEP_t_Result){ (_code), (_msg) })
+
+// In a function returning XCEP_t_Result: returns the failure of _expr to the caller
+#define XCEP_Check(_expr) \
+	do { \
+		const XCEP_t_Result XCEP_v_result = (_expr); \
+		if (XCEP___UNLIKELY(XCEP_v_result.code != 0)) return XCEP_v_result; \
+	} while (0)
+
+// At the boundary: throws the failure of _expr, the only place paying for a Throw
+#define XCEP_TryResult(_expr) \
+	do { \
+		const XCEP_t_Result XCEP_v_result = (_expr); \
+		if (XCEP___UNLIKELY(XCEP_v_result.code != 0)) XCEP_Throw(XCEP_v_result.code, XCEP_v_result.message); \
 	} while (0)
 
-#define XCEP_Throw(_code, _msg) XCEP___Thrown(&XCEP_NewException(_code, _msg))
+// The other way around, in a Catch: the caught exception as a result
+#define XCEP_CaughtResult XCEP_Fail(XCEP_CaughtException.code, XCEP_CaughtException.message)
+
+// =========================================================
+// MARK: Short Commands
+// =========================================================
+
+#if XCEP_CONF_ENABLE_SHORT_COMMANDS
+	typedef XCEP_t_Exception t_Exception;
+	typedef XCEP_t_ExceptionHandler t_ExceptionHandler;
+	typedef XCEP_t_Context t_Context;
+	#define NewException(_code, _msg) XCEP_NewException(_code, _msg)
+	#define Try XCEP_Try
+	#define TryCtx(_ctx) XCEP_TryCtx(_ctx)
+	#define Catch(_code) XCEP_Catch(_code)
+	#define CatchAll XCEP_CatchAll
+	#define CatchAny(...) XCEP_CatchAny(__VA_ARGS__)
+	#define CatchIn(_codes, _count) XCEP_CatchIn(_codes, _count)
+	#define CatchRange(_low, _high) XCEP_CatchRange(_low, _high)
+	#define CatchWhen(_predicate) XCEP_CatchWhen(_predicate)
+	#define CaughtException XCEP_CaughtException
+	#define Finally XCEP_Finally
+	#define EndTry XCEP_EndTry
+	#define Throw(_code, _msg) XCEP_Throw(_code, _msg)
+	#define ThrowCtx(_ctx, _code, _msg) XCEP_ThrowCtx(_ctx, _code, _msg)
+	#define Rethrow XCEP_Rethrow
+	#define PrintException(_text, _exception) XCEP_PrintException(_text, _exception)
+
+	typedef XCEP_t_Result t_Result;
+	#define Ok() XCEP_Ok()
+	#define Fail(_code, _msg) XCEP_Fail(_code, _msg)
+	#define Check(_expr) XCEP_Check(_expr)
+	#define TryResult(_expr) XCEP_TryResult(_expr)
+	#define CaughtResult XCEP_CaughtResult
+
+	#if XCEP_CONF_ENABLE_TWO_PHASE
+		#define TryFilter(_filter) XCEP_TryFilter(_filter)
+		#define TryFilterCtx(_ctx, _filter) XCEP_TryFilterCtx(_ctx, _filter)
+		#define FilterCodes(...) XCEP_FilterCodes(__VA_ARGS__)
+		#define FilterRange(_low, _high) XCEP_FilterRange(_low, _high)
+		#define FilterWhen(_predicate) XCEP_FilterWhen(_predicate)
+	#endif
+
+	#if XCEP_CONF_PAYLOAD_SIZE
+		#define ThrowWith(_code, _msg, _payload) XCEP_ThrowWith(_code, _msg, _payload)
+		#define CaughtPayload(_type) XCEP_CaughtPayload(_type)
+	#endif
+
+	#if XCEP_CONF_MESSAGE_ARENA_SIZE
+		#define ThrowF(_code, ...) XCEP_ThrowF(_code, __VA_ARGS__)
+	#endif
+
+	#if XCEP_CONF_CAUSE_DEPTH
+		#define ThrowWithCause(_code, _msg) XCEP_ThrowWithCause(_code, _msg)
+	#endif
+
+	#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+		#define CatchType(_name) XCEP_CatchType(_name)
+		#define ThrowType(_name, _msg) XCEP_ThrowType(_name, _msg)
+		#define NewTypedException(_name, _msg) XCEP_NewTypedException(_name, _msg)
+		#define IsInstanceOf(_exception, _name) XCEP_IsInstanceOf(_exception, _name)
+	#endif
+
+	#if XCEP_CONF_ENABLE_DEFER
+		#define Defer(_func, _arg) XCEP_Defer(_func, _arg)
+		#define DeferRelease() XCEP_DeferRelease()
+		#define DeferCancel() XCEP_DeferCancel()
+	#endif
+	#define SetUncaughtExceptionHandler(_handler) XCEP_SetUncaughtExceptionHandler(_handler)
+	#if XCEP_CONF_HANDLER_SUBSCRIBERS
+		#define AddUncaughtExceptionHandler(_handler) XCEP_AddUncaughtExceptionHandler(_handler)
+		#define RemoveUncaughtExceptionHandler(_handler) XCEP_RemoveUncaughtExceptionHandler(_handler)
+	#endif
+	#if XCEP_CONF_HANDLER_TABLE_SIZE
+		#define SetCodeUncaughtExceptionHandler(_code, _handler, _previous) XCEP_SetCodeUncaughtExceptionHandler(_code, _handler, _previous)
+	#endif
+
+	#if XCEP_CONF_ENABLE_THREAD_SAFE
+		#define SetThreadUncaughtExceptionHandler(_handler) XCEP_SetThreadUncaughtExceptionHandler(_handler)
+	#endif
+
+#endif
+
+#endif // XCEP_CDAD39BB4CBB62BD_H
+
+#ifdef XCEP_IMPLEMENTATION
+#undef XCEP_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdarg.h>
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+	#if defined(_WIN32)
+		#include <Windows.h>
+	#elif defined(__GLIBC__) || defined(__APPLE__)
+		#include <execinfo.h>
+		#include <unistd.h>
+		#define XCEP___HAVE_BACKTRACE_SYMBOLS 1
+	#endif
+	#include <stdint.h>
+#endif
+
+XCEP_THREAD_LOCAL XCEP_t_Context XCEP_g_Context XCEP___TLS_MODEL = {0};
+#if XCEP_CONF_ENABLE_CONTEXT_SWITCH
+XCEP_THREAD_LOCAL XCEP_t_Context* XCEP_g_CurrentContext XCEP___TLS_MODEL = NULL;
+#endif
+XCEP_t_ExceptionHandler volatile XCEP_g_UncaughtExceptionHandler = NULL;
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+XCEP_t_Type XCEP_TYPE_Exception = {
+	.name = "Exception",
+	.parent = NULL,
+	.code = XCEP_ERR_TYPED,
+	.state = XCEP___TYPE_RESOLVED,
+	.depth = 0,
+	.display = { &XCEP_TYPE_Exception },
+};
+#endif
+
+// =========================================================
+// MARK: Jump Backend ASM
+// =========================================================
+
+#if XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_ASM
+
+#define XCEP___ASM_STR2(_x) #_x
+#define XCEP___ASM_STR(_x) XCEP___ASM_STR2(_x)
+#define XCEP___ASM_CONCAT2(_a, _b) _a##_b
+#define XCEP___ASM_CONCAT(_a, _b) XCEP___ASM_CONCAT2(_a, _b)
+#define XCEP___ASM_SYMBOL(_name) XCEP___ASM_STR(XCEP___ASM_CONCAT(__USER_LABEL_PREFIX__, _name))
+
+#if defined(__ELF__)
+	#define XCEP___ASM_FUNCTION_BEGIN(_name, _type) \
+		".pushsection .text\n.globl " XCEP___ASM_SYMBOL(_name) "\n.p2align 4\n.type " XCEP___ASM_SYMBOL(_name) ", " _type "\n" XCEP___ASM_SYMBOL(_name) ":\n"
+	#define XCEP___ASM_FUNCTION_END(_name) ".size " XCEP___ASM_SYMBOL(_name) ", .-" XCEP___ASM_SYMBOL(_name) "\n.popsection\n"
+#else
+	#define XCEP___ASM_FUNCTION_BEGIN(_name, _type) ".text\n.globl " XCEP___ASM_SYMBOL(_name) "\n.p2align 4\n" XCEP___ASM_SYMBOL(_name) ":\n"
+	#define XCEP___ASM_FUNCTION_END(_name) ""
+#endif
+
+#if defined(__x86_64__)
+
+#if defined(__CET__)
+	#define XCEP___ASM_ENDBR "endbr64\n"
+	#define XCEP___ASM_NOTRACK "notrack "
+#else
+	#define XCEP___ASM_ENDBR ""
+	#define XCEP___ASM_NOTRACK ""
+#endif
+
+// Only the System V callee-saved registers are kept, the signal mask and the
+// shadow stack are left untouched, unlike glibc there is no pointer mangling.
+__asm__(
+	XCEP___ASM_FUNCTION_BEGIN(XCEP___AsmSetJmp, "@function")
+	XCEP___ASM_ENDBR
+	"movq %rbx, 0(%rdi)\n"
+	"movq %rbp, 8(%rdi)\n"
+	"movq %r12, 16(%rdi)\n"
+	"movq %r13, 24(%rdi)\n"
+	"movq %r14, 32(%rdi)\n"
+	"movq %r15, 40(%rdi)\n"
+	"leaq 8(%rsp), %rdx\n"
+	"movq %rdx, 48(%rdi)\n"
+	"movq (%rsp), %rdx\n"
+	"movq %rdx, 56(%rdi)\n"
+	"xorl %eax, %eax\n"
+	"ret\n"
+	XCEP___ASM_FUNCTION_END(XCEP___AsmSetJmp)
+
+	XCEP___ASM_FUNCTION_BEGIN(XCEP___AsmLongJmp, "@function")
+	XCEP___ASM_ENDBR
+	"movq 0(%rdi), %rbx\n"
+	"movq 8(%rdi), %rbp\n"
+	"movq 16(%rdi), %r12\n"
+	"movq 24(%rdi), %r13\n"
+	"movq 32(%rdi), %r14\n"
+	"movq 40(%rdi), %r15\n"
+	"movq 48(%rdi), %rsp\n"
+	"movl $1, %eax\n"
+	XCEP___ASM_NOTRACK "jmpq *56(%rdi)\n"
+	XCEP___ASM_FUNCTION_END(XCEP___AsmLongJmp)
+);
+
+#elif defined(__aarch64__)
+
+// AAPCS64 callee-saved registers: x19-x28, frame pointer, link register, sp and the low halves of v8-v15.
+// Coming back goes through `ret` so the landing site does not need a BTI pad.
+__asm__(
+	XCEP___ASM_FUNCTION_BEGIN(XCEP___AsmSetJmp, "%function")
+	"stp x19, x20, [x0, #0]\n"
+	"stp x21, x22, [x0, #16]\n"
+	"stp x23, x24, [x0, #32]\n"
+	"stp x25, x26, [x0, #48]\n"
+	"stp x27, x28, [x0, #64]\n"
+	"stp x29, x30, [x0, #80]\n"
+	"mov x2, sp\n"
+	"str x2, [x0, #96]\n"
+	"stp d8, d9, [x0, #104]\n"
+	"stp d10, d11, [x0, #120]\n"
+	"stp d12, d13, [x0, #136]\n"
+	"stp d14, d15, [x0, #152]\n"
+	"mov w0, #0\n"
+	"ret\n"
+	XCEP___ASM_FUNCTION_END(XCEP___AsmSetJmp)
+
+	XCEP___ASM_FUNCTION_BEGIN(XCEP___AsmLongJmp, "%function")
+	"ldp x19, x20, [x0, #0]\n"
+	"ldp x21, x22, [x0, #16]\n"
+	"ldp x23, x24, [x0, #32]\n"
+	"ldp x25, x26, [x0, #48]\n"
+	"ldp x27, x28, [x0, #64]\n"
+	"ldp x29, x30, [x0, #80]\n"
+	"ldr x2, [x0, #96]\n"
+	"ldp d8, d9, [x0, #104]\n"
+	"ldp d10, d11, [x0, #120]\n"
+	"ldp d12, d13, [x0, #136]\n"
+	"ldp d14, d15, [x0, #152]\n"
+	"mov sp, x2\n"
+	"mov w0, #1\n"
+	"ret\n"
+	XCEP___ASM_FUNCTION_END(XCEP___AsmLongJmp)
+);
+
+#endif
+
+#endif
+
+// =========================================================
+// MARK: Jump Backend Unwind
+// =========================================================
+
+#if XCEP___JUMP_BACKEND == XCEP_JUMP_BACKEND_UNWIND
+
+#include <unwind.h>
+
+static XCEP_THREAD_LOCAL struct _Unwind_Exception XCEP___g_UnwindException XCEP___TLS_MODEL;
+
+// Called for every frame on the way, the landing pad of the targeted Try never comes back here
+static _Unwind_Reason_Code XCEP___UnwindStop(int inVersion, const _Unwind_Action inActions, const _Unwind_Exception_Class inClass,
+	struct _Unwind_Exception* inException, struct _Unwind_Context* inContext, void* inArg) {
+	(void)inVersion; (void)inClass; (void)inException; (void)inContext; (void)inArg;
+	if (inActions & _UA_END_OF_STACK) {
+		fputs("XCEP: no Try landing pad found by the unwinder, build the code using Try with -fexceptions\n", stderr);
+		abort();
+	}
+	return _URC_NO_REASON;
+}
+
+void XCEP___UnwindTo(XCEP_t_JmpBuf* inEnv) {
+	inEnv->pending = XCEP_TRUE;
+	XCEP___g_UnwindException.exception_class = 0x5843455000000000ull; // "XCEP\0\0\0\0"
+	XCEP___g_UnwindException.exception_cleanup = NULL;
+	_Unwind_ForcedUnwind(&XCEP___g_UnwindException, XCEP___UnwindStop, NULL);
+	abort();
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API || XCEP_CONF_ENABLE_ASYNC_LOG
+
+#if defined(_WIN32)
+	#include <Windows.h>
+	#define XCEP___THREAD_ENTRY(_name, _arg) static DWORD WINAPI _name(LPVOID _arg)
+	#define XCEP___THREAD_RETURN return 0
+	typedef LPTHREAD_START_ROUTINE XCEP___t_ThreadEntry;
+#else
+	#include <time.h>
+	#define XCEP___THREAD_ENTRY(_name, _arg) static void* _name(void* _arg)
+	#define XCEP___THREAD_RETURN return NULL
+	typedef void* (*XCEP___t_ThreadEntry)(void*);
+#endif
+
+static int XCEP___NativeThreadCreate(XCEP___t_NativeThread* outThread, const XCEP___t_ThreadEntry inEntry, void* inArg) {
+#if defined(_WIN32)
+	*outThread = CreateThread(NULL, 0, inEntry, inArg, 0, NULL);
+	return *outThread == NULL ? -1 : 0;
+#else
+	return pthread_create(outThread, NULL, inEntry, inArg) == 0 ? 0 : -1;
+#endif
+}
+
+static void XCEP___NativeThreadJoin(const XCEP___t_NativeThread inThread) {
+#if defined(_WIN32)
+	WaitForSingleObject(inThread, INFINITE);
+	CloseHandle(inThread);
+#else
+	pthread_join(inThread, NULL);
+#endif
+}
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+static void XCEP___SleepMs(const int inMilliseconds) {
+#if defined(_WIN32)
+	Sleep(inMilliseconds);
+#else
+	const struct timespec vDelay = { inMilliseconds / 1000, (inMilliseconds % 1000) * 1000000L };
+	nanosleep(&vDelay, NULL);
+#endif
+}
+#endif
+
+#endif
+
+#if XCEP_CONF_ENABLE_THREAD_API
+
+XCEP___THREAD_ENTRY(XCEP___ThreadMain, inArg) {
+	XCEP_t_Thread* vThread = inArg;
+#if XCEP_CONF_ENABLE_SIGNALS
+	XCEP_SignalsThreadInit();
+#endif
+	XCEP_Try {
+		vThread->func(vThread->arg);
+	}
+	XCEP_CatchAll {
+		XCEP_CaptureException(&vThread->exception);
+	}
+	XCEP_EndTry;
+	XCEP___THREAD_RETURN;
+}
+
+int XCEP_ThreadStart(XCEP_t_Thread* outThread, const XCEP_t_ThreadFunc inFunc, void* inArg) {
+	outThread->func = inFunc;
+	outThread->arg = inArg;
+	outThread->exception.has_exception = XCEP_FALSE;
+	return XCEP___NativeThreadCreate(&outThread->native, XCEP___ThreadMain, outThread);
+}
+
+void XCEP_ThreadJoin(XCEP_t_Thread* inThread) {
+	XCEP___NativeThreadJoin(inThread->native);
+	if (inThread->exception.has_exception) {
+		inThread->exception.has_exception = XCEP_FALSE;
+		XCEP_RethrowCaptured(&inThread->exception);
+	}
+}
+
+// MARK: Task Groups
+
+#if !defined(_WIN32)
+	#include <sched.h>
+#endif
+
+// Worker of the group the calling thread runs tasks for, NULL outside of a group
+static XCEP_THREAD_LOCAL XCEP___t_TaskWorker* XCEP___g_TaskWorker XCEP___TLS_MODEL = NULL;
+// Unfinished tasks queued by the task the calling thread runs, NULL outside of a task
+static XCEP_THREAD_LOCAL volatile long* XCEP___g_TaskScope XCEP___TLS_MODEL = NULL;
+
+static void XCEP___Yield(void) {
+#if defined(_WIN32)
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+static void XCEP___TaskLock(XCEP_t_TaskGroup* inGroup) {
+#if defined(_WIN32)
+	AcquireSRWLockExclusive((PSRWLOCK)&inGroup->lock);
+#else
+	pthread_mutex_lock(&inGroup->lock);
+#endif
+}
+
+static void XCEP___TaskUnlock(XCEP_t_TaskGroup* inGroup) {
+#if defined(_WIN32)
+	ReleaseSRWLockExclusive((PSRWLOCK)&inGroup->lock);
+#else
+	pthread_mutex_unlock(&inGroup->lock);
+#endif
+}
+
+// Wakes one sleeper, or all of them with inAll
+static void XCEP___TaskWake(XCEP_t_TaskGroup* inGroup, const XCEP_t_Bool inAll) {
+	XCEP___TaskLock(inGroup);
+#if defined(_WIN32)
+	if (inAll) WakeAllConditionVariable((PCONDITION_VARIABLE)&inGroup->wake);
+	else WakeConditionVariable((PCONDITION_VARIABLE)&inGroup->wake);
+#else
+	if (inAll) pthread_cond_broadcast(&inGroup->wake);
+	else pthread_cond_signal(&inGroup->wake);
+#endif
+	XCEP___TaskUnlock(inGroup);
+}
+
+static XCEP_t_Bool XCEP___TaskAvailable(XCEP_t_TaskGroup* inGroup) {
+	for (int i = 0; i < inGroup->worker_count; ++i) {
+		if (XCEP___AtomicLoad(&inGroup->deques[i].top) < XCEP___AtomicLoad(&inGroup->deques[i].bottom)) return XCEP_TRUE;
+	}
+	return XCEP_FALSE;
+}
+
+// Blocks while no task is queued, until the group stops or, with inPending, until that count is 0.
+// The sleeper is counted before the deques are checked again, pushes and the last tasks check the count after
+// their own stores: with the fences in between, one side always sees the other.
+static void XCEP___TaskSleep(XCEP_t_TaskGroup* inGroup, const volatile long* inPending) {
+	XCEP___TaskLock(inGroup);
+	XCEP___AtomicAdd(&inGroup->sleepers, 1);
+	XCEP___AtomicFence();
+	const XCEP_t_Bool vBlock = inPending != NULL ? XCEP___AtomicLoad(inPending) != 0 : XCEP___AtomicLoad(&inGroup->running) != 0;
+	if (vBlock && !XCEP___TaskAvailable(inGroup)) {
+	#if defined(_WIN32)
+		SleepConditionVariableSRW((PCONDITION_VARIABLE)&inGroup->wake, (PSRWLOCK)&inGroup->lock, INFINITE, 0);
+	#else
+		pthread_cond_wait(&inGroup->wake, &inGroup->lock);
+	#endif
+	}
+	XCEP___AtomicAdd(&inGroup->sleepers, -1);
+	XCEP___TaskUnlock(inGroup);
+}
+
+static int XCEP___TaskPop(XCEP___t_TaskDeque* inDeque, XCEP___t_Task* outTask) {
+	const long vBottom = inDeque->bottom - 1;
+	XCEP___AtomicStore(&inDeque->bottom, vBottom);
+	XCEP___AtomicFence();
+	const long vTop = XCEP___AtomicLoad(&inDeque->top);
+	if (vTop > vBottom) {
+		XCEP___AtomicStore(&inDeque->bottom, vBottom + 1);
+		return 0;
+	}
+	*outTask = inDeque->tasks[vBottom & (XCEP_CONF_TASK_QUEUE_SIZE - 1)];
+	if (vTop != vBottom) return 1;
+
+	// Last task, a thief may be taking it too
+	const int vWon = XCEP___AtomicCas(&inDeque->top, vTop, vTop + 1);
+	XCEP___AtomicStore(&inDeque->bottom, vBottom + 1);
+	return vWon;
+}
+
+static int XCEP___TaskSteal(XCEP___t_TaskDeque* inDeque, XCEP___t_Task* outTask) {
+	const long vTop = XCEP___AtomicLoad(&inDeque->top);
+	XCEP___AtomicFence();
+	const long vBottom = XCEP___AtomicLoad(&inDeque->bottom);
+	if (vTop >= vBottom) return 0;
+	// The owner never overwrites this slot before top moves past it, the deque cannot wrap around
+	*outTask = inDeque->tasks[vTop & (XCEP_CONF_TASK_QUEUE_SIZE - 1)];
+	return XCEP___AtomicCas(&inDeque->top, vTop, vTop + 1);
+}
+
+static void XCEP___TaskPush(XCEP___t_TaskWorker* inWorker, const XCEP___t_Task* inTask);
+static void XCEP___TaskHelp(XCEP___t_TaskWorker* inWorker, const volatile long* inPending);
+
+static void XCEP___TaskRange(XCEP___t_TaskWorker* inWorker, const XCEP___t_Task* inTask) {
+	long vEnd = inTask->end;
+	// The upper halves are pushed while splitting, thieves take the largest ones from the top
+	while (vEnd - inTask->begin > inTask->grain) {
+		XCEP___t_Task vUpper = *inTask;
+		vUpper.begin = inTask->begin + (vEnd - inTask->begin) / 2;
+		vUpper.end = vEnd;
+		XCEP___TaskPush(inWorker, &vUpper);
+		vEnd = vUpper.begin;
+	}
+	if (XCEP___AtomicLoad(&inWorker->group->cancelled)) return;
+	for (long i = inTask->begin; i < vEnd; ++i) {
+		inTask->body(i, inTask->arg);
+	}
+}
+
+// The task boundary: an exception is kept in the group instead of unwinding the worker
+static void XCEP___TaskExecute(XCEP___t_TaskWorker* inWorker, const XCEP___t_Task* inTask) {
+	XCEP_t_TaskGroup* vGroup = inWorker->group;
+	volatile long vQueued = 0;
+	volatile long* vOuterScope = XCEP___g_TaskScope;
+	XCEP___g_TaskScope = &vQueued;
+	if (XCEP___AtomicLoad(&vGroup->cancelled) == 0) {
+		XCEP_Try {
+			if (inTask->body != NULL) XCEP___TaskRange(inWorker, inTask);
+			else inTask->func(inTask->arg);
+		}
+		XCEP_Catch(XCEP_ERR_CANCELLED) {
+		}
+		XCEP_CatchAll {
+			const long vIndex = XCEP___AtomicAdd(&vGroup->error_count, 1);
+			if (vIndex < XCEP_CONF_TASK_MAX_ERRORS) XCEP_CaptureException(&vGroup->errors[vIndex]);
+			if (vGroup->rethrow == XCEP_TASK_RETHROW_FIRST) XCEP___AtomicStore(&vGroup->cancelled, 1);
+		}
+		XCEP_EndTry;
+	}
+	// The tasks it queued and did not wait for count in vQueued, they must end before it goes away
+	XCEP___TaskHelp(inWorker, &vQueued);
+	XCEP___g_TaskScope = vOuterScope;
+
+	// Wakes the outermost wait, or the task waiting for this one
+	XCEP_t_Bool vLast = XCEP___AtomicAdd(&vGroup->pending, -1) == 1;
+	if (inTask->scope != NULL && XCEP___AtomicAdd(inTask->scope, -1) == 1) vLast = XCEP_TRUE;
+	if (vLast) {
+		XCEP___AtomicFence();
+		if (XCEP___AtomicLoad(&vGroup->sleepers) != 0) XCEP___TaskWake(vGroup, XCEP_TRUE);
+	}
+}
+
+static void XCEP___TaskPush(XCEP___t_TaskWorker* inWorker, const XCEP___t_Task* inTask) {
+	XCEP_t_TaskGroup* vGroup = inWorker->group;
+	// Skipped right away, as it would be once taken from the deque
+	if (XCEP___AtomicLoad(&vGroup->cancelled)) return;
+
+	XCEP___t_TaskDeque* vDeque = &vGroup->deques[inWorker->index];
+	XCEP___AtomicAdd(&vGroup->pending, 1);
+	if (inTask->scope != NULL) XCEP___AtomicAdd(inTask->scope, 1);
+	const long vBottom = vDeque->bottom;
+	if (vBottom - XCEP___AtomicLoad(&vDeque->top) >= XCEP_CONF_TASK_QUEUE_SIZE) {
+		// Deque full, run now: the caller may be the waiting thread before XCEP_TaskGroupWait,
+		// XCEP_CheckCancel in the task must still see the group
+		XCEP___t_TaskWorker* vPrevious = XCEP___g_TaskWorker;
+		XCEP___g_TaskWorker = inWorker;
+		XCEP___TaskExecute(inWorker, inTask);
+		XCEP___g_TaskWorker = vPrevious;
+		return;
+	}
+	vDeque->tasks[vBottom & (XCEP_CONF_TASK_QUEUE_SIZE - 1)] = *inTask;
+	XCEP___AtomicStore(&vDeque->bottom, vBottom + 1);
+
+	XCEP___AtomicFence();
+	if (XCEP___AtomicLoad(&vGroup->sleepers) != 0) XCEP___TaskWake(vGroup, XCEP_FALSE);
+}
+
+// Own deque first, then steal from the next workers in turn
+static int XCEP___TaskRunOne(XCEP___t_TaskWorker* inWorker) {
+	XCEP_t_TaskGroup* vGroup = inWorker->group;
+	XCEP___t_Task vTask;
+	int vFound = XCEP___TaskPop(&vGroup->deques[inWorker->index], &vTask);
+	for (int i = 1; !vFound && i < vGroup->worker_count; ++i) {
+		vFound = XCEP___TaskSteal(&vGroup->deques[(inWorker->index + i) % vGroup->worker_count], &vTask);
+	}
+	if (vFound) XCEP___TaskExecute(inWorker, &vTask);
+	return vFound;
+}
+
+// Runs tasks until *inPending is 0, blocking as the workers do while the last ones run elsewhere
+static void XCEP___TaskHelp(XCEP___t_TaskWorker* inWorker, const volatile long* inPending) {
+	int vIdle = 0;
+	while (XCEP___AtomicLoad(inPending) != 0) {
+		if (XCEP___TaskRunOne(inWorker)) vIdle = 0;
+		else if (++vIdle < 64) XCEP___Yield();
+		else {
+			XCEP___TaskSleep(inWorker->group, inPending);
+			vIdle = 0;
+		}
+	}
+}
+
+// Where a push from the calling thread goes: its own worker in a task of inGroup, worker 0 otherwise
+static XCEP___t_TaskWorker* XCEP___TaskCaller(XCEP_t_TaskGroup* inGroup, volatile long** outScope) {
+	XCEP___t_TaskWorker* vWorker = XCEP___g_TaskWorker;
+	if (vWorker != NULL && vWorker->group == inGroup) {
+		*outScope = XCEP___g_TaskScope;
+		return vWorker;
+	}
+	*outScope = NULL;
+	return &inGroup->workers[0];
+}
+
+XCEP___THREAD_ENTRY(XCEP___TaskWorkerMain, inArg) {
+	XCEP___t_TaskWorker* vWorker = inArg;
+	XCEP___g_TaskWorker = vWorker;
+#if XCEP_CONF_ENABLE_SIGNALS
+	XCEP_SignalsThreadInit();
+#endif
+	int vIdle = 0;
+	// An idle worker yields a few times before blocking, tasks often come in bursts
+	while (XCEP___AtomicLoad(&vWorker->group->running)) {
+		if (XCEP___TaskRunOne(vWorker)) vIdle = 0;
+		else if (++vIdle < 64) XCEP___Yield();
+		else {
+			XCEP___TaskSleep(vWorker->group, NULL);
+			vIdle = 0;
+		}
+	}
+	XCEP___THREAD_RETURN;
+}
+
+int XCEP_TaskGroupInit(XCEP_t_TaskGroup* outGroup, int inWorkers, const XCEP_t_TaskRethrow inRethrow) {
+	if (inWorkers < 1) inWorkers = 1;
+	if (inWorkers > XCEP_CONF_TASK_MAX_WORKERS) inWorkers = XCEP_CONF_TASK_MAX_WORKERS;
+
+	memset(outGroup, 0, sizeof(*outGroup));
+	outGroup->rethrow = inRethrow;
+	outGroup->worker_count = inWorkers;
+	outGroup->running = 1;
+#if !defined(_WIN32)
+	// Zeroed SRWLOCK and CONDITION_VARIABLE are already initialized
+	if (pthread_mutex_init(&outGroup->lock, NULL) != 0) return -1;
+	if (pthread_cond_init(&outGroup->wake, NULL) != 0) {
+		pthread_mutex_destroy(&outGroup->lock);
+		return -1;
+	}
+#endif
+	for (int i = 0; i < inWorkers; ++i) {
+		outGroup->workers[i].group = outGroup;
+		outGroup->workers[i].index = i;
+	}
+
+	for (int i = 1; i < inWorkers; ++i) {
+		if (XCEP___NativeThreadCreate(&outGroup->threads[i], XCEP___TaskWorkerMain, &outGroup->workers[i]) != 0) {
+			XCEP___AtomicStore(&outGroup->running, 0);
+			XCEP___TaskWake(outGroup, XCEP_TRUE);
+			while (--i > 0) XCEP___NativeThreadJoin(outGroup->threads[i]);
+		#if !defined(_WIN32)
+			pthread_cond_destroy(&outGroup->wake);
+			pthread_mutex_destroy(&outGroup->lock);
+		#endif
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void XCEP_TaskGroupRun(XCEP_t_TaskGroup* inGroup, const XCEP_t_TaskFunc inFunc, void* inArg) {
+	volatile long* vScope;
+	XCEP___t_TaskWorker* vWorker = XCEP___TaskCaller(inGroup, &vScope);
+	const XCEP___t_Task vTask = { .func = inFunc, .arg = inArg, .scope = vScope };
+	XCEP___TaskPush(vWorker, &vTask);
+}
+
+void XCEP_TaskGroupWait(XCEP_t_TaskGroup* inGroup) {
+	volatile long* vScope;
+	XCEP___t_TaskWorker* vWorker = XCEP___TaskCaller(inGroup, &vScope);
+	if (vScope != NULL) {
+		// In a task: pending counts this one, only its own tasks are waited for, on its own worker
+		XCEP___TaskHelp(vWorker, vScope);
+		XCEP_CheckCancel();
+		return;
+	}
+
+	XCEP___t_TaskWorker* vPrevious = XCEP___g_TaskWorker;
+	volatile long* vOuterScope = XCEP___g_TaskScope;
+	XCEP___g_TaskWorker = &inGroup->workers[0];
+	XCEP___g_TaskScope = NULL;
+	XCEP___TaskHelp(&inGroup->workers[0], &inGroup->pending);
+	XCEP___g_TaskWorker = vPrevious;
+	XCEP___g_TaskScope = vOuterScope;
+
+	// Every task is done, the group is ready for the next batch before anything is thrown
+	inGroup->failed = XCEP___AtomicLoad(&inGroup->error_count);
+	XCEP___AtomicStore(&inGroup->error_count, 0);
+	XCEP___AtomicStore(&inGroup->cancelled, 0);
+	if (inGroup->failed == 0) return;
+
+	if (inGroup->rethrow == XCEP_TASK_RETHROW_FIRST) {
+		XCEP_RethrowCaptured(&inGroup->errors[0]);
+	}
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+	XCEP_ThrowF(XCEP_ERR_TASKS_FAILED, "%ld task(s) failed", inGroup->failed);
+#else
+	XCEP_Throw(XCEP_ERR_TASKS_FAILED, "Tasks failed");
+#endif
+}
+
+void XCEP_TaskGroupCancel(XCEP_t_TaskGroup* inGroup) {
+	XCEP___AtomicStore(&inGroup->cancelled, 1);
+}
+
+void XCEP_TaskGroupDestroy(XCEP_t_TaskGroup* inGroup) {
+	assert(inGroup->pending == 0 && "XCEP_TaskGroupWait must be called before XCEP_TaskGroupDestroy.");
+	XCEP___AtomicStore(&inGroup->running, 0);
+	XCEP___TaskWake(inGroup, XCEP_TRUE);
+	for (int i = 1; i < inGroup->worker_count; ++i) {
+		XCEP___NativeThreadJoin(inGroup->threads[i]);
+	}
+#if !defined(_WIN32)
+	pthread_cond_destroy(&inGroup->wake);
+	pthread_mutex_destroy(&inGroup->lock);
+#endif
+}
+
+void XCEP_ParallelFor(XCEP_t_TaskGroup* inGroup, const long inBegin, const long inEnd, const long inGrain, const XCEP_t_IndexFunc inBody, void* inArg) {
+	if (inBegin < inEnd) {
+		volatile long* vScope;
+		XCEP___t_TaskWorker* vWorker = XCEP___TaskCaller(inGroup, &vScope);
+		const XCEP___t_Task vTask = { .body = inBody, .arg = inArg, .begin = inBegin, .end = inEnd, .grain = inGrain > 0 ? inGrain : 1,
+			.scope = vScope };
+		XCEP___TaskPush(vWorker, &vTask);
+	}
+	XCEP_TaskGroupWait(inGroup);
+}
+
+void XCEP_CheckCancel(void) {
+	const XCEP___t_TaskWorker* vWorker = XCEP___g_TaskWorker;
+	if (vWorker != NULL && XCEP___AtomicLoad(&vWorker->group->cancelled)) {
+		XCEP_Throw(XCEP_ERR_CANCELLED, "Task group cancelled");
+	}
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+static const XCEP_t_SiteRecord XCEP___g_UnknownSite = { "?", "?", 0 };
+
+static const XCEP_t_SiteRecord* XCEP___SiteOrUnknown(const XCEP_t_Uint inSiteId) {
+	const XCEP_t_SiteRecord* vSite = XCEP_SiteLookup(inSiteId);
+	return vSite ? vSite : &XCEP___g_UnknownSite;
+}
+#endif
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+
+typedef struct {
+	const char* format; // One of the static XCEP_FormatException formats
+	XCEP_t_Int code;
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+	XCEP_t_Uint site_id; // Looked up by the consumer
+#elif XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+	XCEP_t_Int line;
+	const char* file;
+	const char* function;
+#endif
+	char message[XCEP_CONF_LOG_MESSAGE_SIZE];
+#if XCEP_CONF_BACKTRACE_DEPTH
+	XCEP_t_Uint backtrace_size; // 0 unless pushed while printing the last thrown exception of the thread
+	void* backtrace[XCEP_CONF_BACKTRACE_DEPTH];
+#endif
+} XCEP_t_LogRecord;
+
+// Bounded MPSC queue: a cell is free for the producer at position p when its sequence is p,
+// readable by the consumer when it is p + 1
+typedef struct {
+	volatile long sequence;
+	XCEP_t_LogRecord record;
+} XCEP_t_LogCell;
+
+static XCEP_t_LogCell XCEP___g_LogRing[XCEP_CONF_LOG_RING_SIZE];
+static volatile long XCEP___g_LogEnqueuePos = 0;
+static volatile long XCEP___g_LogDequeuePos = 0;
+static volatile long XCEP___g_LogInitialized = 0; // 0, 1 while the sequences are written, 2 once ready
+static volatile long XCEP___g_LogConsumer = 0;    // Taken by the single thread draining the ring
+static volatile long XCEP___g_LogRunning = 0;
+static volatile long long XCEP___g_LogDropped = 0;
+static FILE* XCEP___g_LogOutput = NULL;
+
+static XCEP___t_NativeThread XCEP___g_LogThread;
+
+// Signed distance of two ring positions, positions wrap around
+#define XCEP___LOG_DIFF(_a, _b) ((long)((unsigned long)(_a) - (unsigned long)(_b)))
+
+static void XCEP___LogAtExit(void) {
+	XCEP_LogFlush();
+}
+
+static void XCEP___LogInit(void) {
+	if (XCEP___AtomicLoad(&XCEP___g_LogInitialized) == 2) return;
+	if (XCEP___AtomicCas(&XCEP___g_LogInitialized, 0, 1)) {
+		for (long i = 0; i < XCEP_CONF_LOG_RING_SIZE; ++i) {
+			XCEP___g_LogRing[i].sequence = i;
+		}
+		// Records pushed right before a normal exit are not lost
+		atexit(XCEP___LogAtExit);
+		XCEP___AtomicStore(&XCEP___g_LogInitialized, 2);
+	} else {
+		while (XCEP___AtomicLoad(&XCEP___g_LogInitialized) != 2) { }
+	}
+}
+
+// Lock-free, never blocks: when the ring is full the record is dropped
+static void XCEP___LogPush(const char* inFormat, const XCEP_t_Exception* inException, const XCEP_t_Bool inWithBacktrace) {
+	XCEP___LogInit();
+
+	XCEP_t_LogCell* vCell;
+	long vPos = XCEP___AtomicLoad(&XCEP___g_LogEnqueuePos);
+	for (;;) {
+		vCell = &XCEP___g_LogRing[(unsigned long)vPos & (XCEP_CONF_LOG_RING_SIZE - 1)];
+		const long vDiff = XCEP___LOG_DIFF(XCEP___AtomicLoad(&vCell->sequence), vPos);
+		if (vDiff == 0) {
+			if (XCEP___AtomicCas(&XCEP___g_LogEnqueuePos, vPos, (long)((unsigned long)vPos + 1))) break;
+		} else if (vDiff < 0) {
+			XCEP___AtomicAddRelaxed(&XCEP___g_LogDropped, 1);
+			return;
+		}
+		vPos = XCEP___AtomicLoad(&XCEP___g_LogEnqueuePos);
+	}
+
+	XCEP_t_LogRecord* vRecord = &vCell->record;
+	vRecord->format = inFormat;
+	vRecord->code = inException->code;
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+	vRecord->site_id = inException->site_id;
+#elif XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+	vRecord->line = inException->line;
+	vRecord->file = inException->file;
+	vRecord->function = inException->function;
+#endif
+	const char* vMessage = inException->message ? inException->message : "";
+	size_t vLength = strlen(vMessage);
+	if (vLength >= XCEP_CONF_LOG_MESSAGE_SIZE) vLength = XCEP_CONF_LOG_MESSAGE_SIZE - 1;
+	memcpy(vRecord->message, vMessage, vLength);
+	vRecord->message[vLength] = '\0';
+#if XCEP_CONF_BACKTRACE_DEPTH
+	const XCEP_t_Context* vContext = XCEP_GetContext();
+	vRecord->backtrace_size = inWithBacktrace ? vContext->backtrace_size : 0;
+	memcpy(vRecord->backtrace, vContext->backtrace, vRecord->backtrace_size * sizeof(void*));
+#else
+	(void)inWithBacktrace;
+#endif
+
+	XCEP___AtomicStore(&vCell->sequence, (long)((unsigned long)vPos + 1));
+}
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+// Symbolized by the drainer, never by the throwing thread
+static void XCEP___LogWriteBacktrace(FILE* inOutput, const XCEP_t_LogRecord* inRecord) {
+#if defined(XCEP___HAVE_BACKTRACE_SYMBOLS)
+	char** vSymbols = backtrace_symbols(inRecord->backtrace, (int)inRecord->backtrace_size);
+	if (vSymbols != NULL) {
+		for (XCEP_t_Uint i = 0; i < inRecord->backtrace_size; ++i) {
+			fprintf(inOutput, "\t#%u %s\n", (unsigned)i, vSymbols[i]);
+		}
+		free(vSymbols);
+		return;
+	}
+#endif
+	for (XCEP_t_Uint i = 0; i < inRecord->backtrace_size; ++i) {
+		fprintf(inOutput, "\t#%u %p\n", (unsigned)i, inRecord->backtrace[i]);
+	}
+}
+#endif
+
+// Formats every readable record into a buffer written with one fwrite per batch, returns XCEP_FALSE
+// when another thread is the consumer
+static XCEP_t_Bool XCEP___LogDrain(void) {
+	if (!XCEP___AtomicCas(&XCEP___g_LogConsumer, 0, 1)) return XCEP_FALSE;
+	XCEP___LogInit();
+
+	FILE* vOutput = XCEP___g_LogOutput ? XCEP___g_LogOutput : stderr;
+	char vBatch[8192];
+	size_t vBatchSize = 0;
+	XCEP_t_Bool vWritten = XCEP_FALSE;
+	long vPos = XCEP___g_LogDequeuePos;
+	for (;;) {
+		XCEP_t_LogCell* vCell = &XCEP___g_LogRing[(unsigned long)vPos & (XCEP_CONF_LOG_RING_SIZE - 1)];
+		const XCEP_t_Bool vReadable = XCEP___LOG_DIFF(XCEP___AtomicLoad(&vCell->sequence), (unsigned long)vPos + 1) == 0;
+
+		if (vBatchSize > 0 && (!vReadable || vBatchSize + XCEP_CONF_LOG_MESSAGE_SIZE + 512 > sizeof(vBatch))) {
+			fwrite(vBatch, 1, vBatchSize, vOutput);
+			vBatchSize = 0;
+			vWritten = XCEP_TRUE;
+		}
+		if (!vReadable) break;
+
+		const XCEP_t_LogRecord* vRecord = &vCell->record;
+	#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+		const XCEP_t_SiteRecord* vSite = XCEP___SiteOrUnknown(vRecord->site_id);
+	#endif
+		const int vLength = snprintf(vBatch + vBatchSize, sizeof(vBatch) - vBatchSize, vRecord->format,
+				vRecord->code,
+				vRecord->message
+			#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+				,vSite->function
+				,vSite->file
+				,vSite->line
+			#elif XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+				,vRecord->function
+				,vRecord->file
+				,vRecord->line
+			#endif
+		);
+		if (vLength > 0) {
+			vBatchSize += (size_t)vLength < sizeof(vBatch) - vBatchSize ? (size_t)vLength : sizeof(vBatch) - vBatchSize - 1;
+		}
+	#if XCEP_CONF_BACKTRACE_DEPTH
+		// The frames go right after their record, the batch is written first
+		if (vRecord->backtrace_size > 0) {
+			fwrite(vBatch, 1, vBatchSize, vOutput);
+			vBatchSize = 0;
+			vWritten = XCEP_TRUE;
+			XCEP___LogWriteBacktrace(vOutput, vRecord);
+		}
+	#endif
+
+		vPos = (long)((unsigned long)vPos + 1);
+		XCEP___AtomicStore(&vCell->sequence, (long)((unsigned long)vPos + XCEP_CONF_LOG_RING_SIZE - 1));
+		XCEP___AtomicStore(&XCEP___g_LogDequeuePos, vPos);
+	}
+	if (vWritten) fflush(vOutput);
+
+	XCEP___AtomicStore(&XCEP___g_LogConsumer, 0);
+	return XCEP_TRUE;
+}
+
+XCEP___THREAD_ENTRY(XCEP___LogThreadMain, inArg) {
+	(void)inArg;
+	while (XCEP___AtomicLoad(&XCEP___g_LogRunning)) {
+		XCEP___LogDrain();
+		XCEP___SleepMs(1);
+	}
+	XCEP___LogDrain();
+	XCEP___THREAD_RETURN;
+}
+
+int XCEP_LogStart(FILE* inOutput) {
+	XCEP___LogInit();
+	if (!XCEP___AtomicCas(&XCEP___g_LogRunning, 0, 1)) return -1;
+	XCEP___g_LogOutput = inOutput;
+
+	if (XCEP___NativeThreadCreate(&XCEP___g_LogThread, XCEP___LogThreadMain, NULL) != 0) {
+		XCEP___AtomicStore(&XCEP___g_LogRunning, 0);
+		return -1;
+	}
+	return 0;
+}
+
+void XCEP_LogFlush(void) {
+	const long vTarget = XCEP___AtomicLoad(&XCEP___g_LogEnqueuePos);
+	// Records reserved before vTarget but still being written are waited for as well
+	while (XCEP___LOG_DIFF(vTarget, XCEP___AtomicLoad(&XCEP___g_LogDequeuePos)) > 0) {
+		if (!XCEP___LogDrain() || XCEP___LOG_DIFF(vTarget, XCEP___AtomicLoad(&XCEP___g_LogDequeuePos)) > 0) {
+			XCEP___SleepMs(1);
+		}
+	}
+}
+
+void XCEP_LogStop(void) {
+	if (!XCEP___AtomicCas(&XCEP___g_LogRunning, 1, 0)) {
+		XCEP_LogFlush();
+		return;
+	}
+	XCEP___NativeThreadJoin(XCEP___g_LogThread);
+	XCEP_LogFlush();
+	XCEP___g_LogOutput = NULL;
+}
+
+long long XCEP_LogDropped(void) {
+	return XCEP___AtomicLoadRelaxed(&XCEP___g_LogDropped);
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_STATS
+
+static XCEP_t_ThrowSite* volatile XCEP___g_StatsSites = NULL;
+static volatile long long XCEP___g_StatsNextShard = 0;
+
+// A couple of relaxed increments on the thread's own shard once the site is registered
+static void XCEP___StatsCount(XCEP_t_Context* inContext, XCEP_t_ThrowSite* inSite, const XCEP_t_StatsCounter inCounter) {
+	if (inSite == NULL) return;
+
+	if (inContext->stats_shard == 0) {
+		inContext->stats_shard = (XCEP_t_Uint)(XCEP___AtomicAddRelaxed(&XCEP___g_StatsNextShard, 1) % XCEP_CONF_STATS_SHARDS) + 1;
+	}
+	XCEP___AtomicAddRelaxed(&inSite->shards[inContext->stats_shard - 1].counters[inCounter], 1);
+}
+
+static void XCEP___StatsRegister(XCEP_t_ThrowSite* inSite, const XCEP_t_Int inCode) {
+	if (inSite == NULL || XCEP___AtomicLoad(&inSite->registered) || !XCEP___AtomicCas(&inSite->registered, 0, 1)) return;
+
+	inSite->code = inCode;
+	XCEP_t_ThrowSite* vHead;
+	do {
+		vHead = XCEP___AtomicLoad(&XCEP___g_StatsSites);
+		inSite->next = vHead;
+	} while (!XCEP___AtomicCasPtr(&XCEP___g_StatsSites, vHead, inSite));
+}
+
+size_t XCEP_StatsSnapshot(XCEP_t_SiteStats* outStats, const size_t inCapacity) {
+	size_t vCount = 0;
+	for (const XCEP_t_ThrowSite* vSite = XCEP___AtomicLoad(&XCEP___g_StatsSites); vSite != NULL; vSite = vSite->next, ++vCount) {
+		if (vCount >= inCapacity) continue;
+
+		XCEP_t_SiteStats* vStats = &outStats[vCount];
+		memset(vStats, 0, sizeof(*vStats));
+		vStats->site = vSite;
+		for (int vShard = 0; vShard < XCEP_CONF_STATS_SHARDS; ++vShard) {
+			for (int vCounter = 0; vCounter < XCEP_STATS_COUNT; ++vCounter) {
+				vStats->counters[vCounter] += XCEP___AtomicLoadRelaxed(&vSite->shards[vShard].counters[vCounter]);
+			}
+		}
+	}
+	return vCount;
+}
+
+#endif
+
+// =========================================================
+// MARK: Flight Recorder
+// =========================================================
+
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+	#include <sys/syscall.h>
+#elif defined(__APPLE__)
+	#include <pthread.h>
+#endif
+
+static XCEP_t_RecorderHeader* volatile XCEP___g_RecorderFile = NULL;
+static size_t XCEP___g_RecorderSize = 0;
+// Bumped by every open and close, a context whose generation differs claims a region again
+static volatile long XCEP___g_RecorderGeneration = 0;
+
+#define XCEP___RECORDER_REGION_SIZE (sizeof(XCEP_t_RecorderRegion) + XCEP_CONF_RECORDER_EVENTS * sizeof(XCEP_t_RecorderEvent))
+
+// vDSO on Linux, no system call
+static unsigned long long XCEP___RecorderNowNs(const clockid_t inClock) {
+	struct timespec vNow;
+	clock_gettime(inClock, &vNow);
+	return (unsigned long long)vNow.tv_sec * 1000000000ull + (unsigned long long)vNow.tv_nsec;
+}
+
+static void XCEP___RecorderCopy(char* outText, const char* inText, const size_t inSize) {
+	size_t i = 0;
+	if (inText != NULL) {
+		for (; i < inSize - 1 && inText[i] != '\0'; ++i) outText[i] = inText[i];
+	}
+	outText[i] = '\0';
+}
+
+static XCEP___NOINLINE void XCEP___RecorderClaim(XCEP_t_Context* inContext, const long inGeneration) {
+	XCEP_t_RecorderHeader* vFile = XCEP___AtomicLoad(&XCEP___g_RecorderFile);
+	inContext->recorder_generation = inGeneration;
+	inContext->recorder_region = NULL;
+	if (vFile == NULL) return;
+
+	const long long vIndex = XCEP___AtomicAdd(&vFile->regions_claimed, 1);
+	if (vIndex >= (long long)vFile->region_count) return;
+
+	XCEP_t_RecorderRegion* vRegion = (XCEP_t_RecorderRegion*)((char*)vFile + sizeof(XCEP_t_RecorderHeader) + (size_t)vIndex * XCEP___RECORDER_REGION_SIZE);
+#if defined(__linux__)
+	vRegion->thread_id = (unsigned long long)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+	uint64_t vThreadId = 0;
+	pthread_threadid_np(NULL, &vThreadId);
+	vRegion->thread_id = vThreadId;
+#endif
+	inContext->recorder_region = vRegion;
+}
+
+void XCEP___RecorderAppend(XCEP_t_Context* inContext, const XCEP_t_Uint inKind, const XCEP_t_Exception* inException) {
+	const long vGeneration = XCEP___AtomicLoad(&XCEP___g_RecorderGeneration);
+	if (XCEP___UNLIKELY(inContext->recorder_generation != vGeneration)) {
+		XCEP___RecorderClaim(inContext, vGeneration);
+	}
+	XCEP_t_RecorderRegion* vRegion = inContext->recorder_region;
+	if (vRegion == NULL) return;
+
+	// Only this thread writes its region
+	const unsigned long long vHead = vRegion->head;
+	XCEP_t_RecorderEvent* vEvent = (XCEP_t_RecorderEvent*)(vRegion + 1) + (vHead & (XCEP_CONF_RECORDER_EVENTS - 1));
+	vEvent->time_ns = XCEP___RecorderNowNs(CLOCK_MONOTONIC);
+	vEvent->code = (int)inException->code;
+	vEvent->kind = (unsigned char)inKind;
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+	const XCEP_t_SiteRecord* vSite = XCEP___SiteOrUnknown(inException->site_id);
+	vEvent->line = (unsigned int)vSite->line;
+	XCEP___RecorderCopy(vEvent->function, vSite->function, sizeof(vEvent->function));
+#elif XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+	vEvent->line = (unsigned int)inException->line;
+	XCEP___RecorderCopy(vEvent->function, inException->function, sizeof(vEvent->function));
+#else
+	vEvent->line = 0;
+	vEvent->function[0] = '\0';
+#endif
+	XCEP___RecorderCopy(vEvent->message, inException->message, sizeof(vEvent->message));
+
+	// Counted once complete. Once the ring wrapped, the slot being written is also the oldest counted event:
+	// a process killed in the middle tears it, readers keep only the last region_events - 1 events.
+	XCEP___AtomicStore(&vRegion->head, vHead + 1);
+}
+
+int XCEP_RecorderOpen(const char* inPath) {
+	if (XCEP___AtomicLoad(&XCEP___g_RecorderFile) != NULL) {
+		errno = EBUSY;
+		return -1;
+	}
+
+	const size_t vSize = sizeof(XCEP_t_RecorderHeader) + XCEP_CONF_RECORDER_REGIONS * XCEP___RECORDER_REGION_SIZE;
+	const int vFd = open(inPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (vFd < 0) return -1;
+	// Sparse file, the pages of a region are only backed once its thread writes them
+	if (ftruncate(vFd, (off_t)vSize) != 0) {
+		close(vFd);
+		return -1;
+	}
+	void* vMapping = mmap(NULL, vSize, PROT_READ | PROT_WRITE, MAP_SHARED, vFd, 0);
+	close(vFd);
+	if (vMapping == MAP_FAILED) return -1;
+
+	XCEP_t_RecorderHeader* vFile = vMapping;
+	memcpy(vFile->magic, XCEP_RECORDER_MAGIC, sizeof(vFile->magic));
+	vFile->version = XCEP_RECORDER_VERSION;
+	vFile->header_size = (unsigned int)sizeof(XCEP_t_RecorderHeader);
+	vFile->region_size = (unsigned int)XCEP___RECORDER_REGION_SIZE;
+	vFile->region_count = XCEP_CONF_RECORDER_REGIONS;
+	vFile->region_events = XCEP_CONF_RECORDER_EVENTS;
+	vFile->event_size = (unsigned int)sizeof(XCEP_t_RecorderEvent);
+	vFile->pid = (unsigned long long)getpid();
+	vFile->start_monotonic_ns = XCEP___RecorderNowNs(CLOCK_MONOTONIC);
+	vFile->start_realtime_ns = XCEP___RecorderNowNs(CLOCK_REALTIME);
+	vFile->regions_claimed = 0;
+
+	XCEP___g_RecorderSize = vSize;
+	XCEP___AtomicStore(&XCEP___g_RecorderFile, vFile);
+	XCEP___AtomicAdd(&XCEP___g_RecorderGeneration, 1);
+	return 0;
+}
+
+void XCEP_RecorderClose(void) {
+	XCEP_t_RecorderHeader* vFile = XCEP___AtomicLoad(&XCEP___g_RecorderFile);
+	if (vFile == NULL) return;
+	XCEP___AtomicStore(&XCEP___g_RecorderFile, (XCEP_t_RecorderHeader*)NULL);
+	XCEP___AtomicAdd(&XCEP___g_RecorderGeneration, 1);
+	munmap(vFile, XCEP___g_RecorderSize);
+}
+
+#endif
+
+// =========================================================
+// MARK: Try Depth
+// =========================================================
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS
+static volatile long XCEP___g_DepthMax = 0;
+static volatile long long XCEP___g_DepthContexts = 0;
+static volatile long long XCEP___g_DepthLimitHits = 0;
+#endif
+
+#if XCEP___TRACK_DEPTH
+
+// Entering a Try deeper than the context ever went: new high-water mark, or the limit
+void XCEP___DepthRaise(XCEP_t_Context* inContext) {
+#if XCEP_CONF_TRY_DEPTH_LIMIT
+	if (inContext->try_depth > XCEP_CONF_TRY_DEPTH_LIMIT) {
+		// The frame is not pushed yet, the exception goes to the enclosing Try
+		inContext->try_depth--;
+	#if XCEP_CONF_ENABLE_DEPTH_STATS
+		XCEP___AtomicAddRelaxed(&XCEP___g_DepthLimitHits, 1);
+	#endif
+		XCEP___ThrownCtx(inContext, &XCEP_NewException(XCEP_ERR_TRY_DEPTH, "Try nested deeper than XCEP_CONF_TRY_DEPTH_LIMIT"));
+		// Only reached when an uncaught exception handler returned, the Try is entered anyway
+		inContext->try_depth++;
+	}
+#endif
+	inContext->try_depth_max = inContext->try_depth;
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS
+	if (inContext->try_depth_max == 1) XCEP___AtomicAddRelaxed(&XCEP___g_DepthContexts, 1);
+	long vMax;
+	do {
+		vMax = XCEP___AtomicLoad(&XCEP___g_DepthMax);
+	} while (vMax < (long)inContext->try_depth_max && !XCEP___AtomicCas(&XCEP___g_DepthMax, vMax, (long)inContext->try_depth_max));
+#endif
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_DEPTH_STATS
+
+void XCEP_TryDepthSnapshot(XCEP_t_TryDepthStats* outStats) {
+	outStats->max_depth = (XCEP_t_Uint)XCEP___AtomicLoad(&XCEP___g_DepthMax);
+	outStats->max_frame_bytes = outStats->max_depth * XCEP_TRY_FRAME_SIZE;
+	outStats->contexts = XCEP___AtomicLoadRelaxed(&XCEP___g_DepthContexts);
+	outStats->limit_hits = XCEP___AtomicLoadRelaxed(&XCEP___g_DepthLimitHits);
+}
+
+#endif
+
+// =========================================================
+// MARK: Latency
+// =========================================================
+
+#if XCEP_CONF_ENABLE_LATENCY
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define XCEP___LATENCY_TSC 1
+	#define XCEP___Ticks() ((unsigned long long)__rdtsc())
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define XCEP___LATENCY_TSC 1
+	#define XCEP___Ticks() ((unsigned long long)__builtin_ia32_rdtsc())
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+	XCEP___INLINE unsigned long long XCEP___Ticks(void) {
+		unsigned long long vTicks;
+		__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(vTicks));
+		return vTicks;
+	}
+#else
+	#define XCEP___LATENCY_CLOCK 1
+	#define XCEP___Ticks() XCEP___LatencyNowNs()
+#endif
+
+#include <time.h>
+
+static unsigned long long XCEP___LatencyNowNs(void) {
+	struct timespec vNow;
+#if defined(_WIN32)
+	timespec_get(&vNow, TIME_UTC);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &vNow);
+#endif
+	return (unsigned long long)vNow.tv_sec * 1000000000ull + (unsigned long long)vNow.tv_nsec;
+}
+
+// Slots are claimed once (EMPTY -> CLAIMED -> READY) by the first catch of their code, as the handler table slots
+#define XCEP___LATENCY_EMPTY 0
+#define XCEP___LATENCY_CLAIMED 1
+#define XCEP___LATENCY_READY 2
+
+typedef struct {
+	volatile long long count;
+	volatile long long latency[XCEP_LATENCY_BUCKETS];
+	volatile long long hops[XCEP_HOPS_BUCKETS];
+} XCEP___t_LatencyCounters;
+
+static struct {
+	volatile long state;
+	XCEP_t_Int code;
+} XCEP___g_LatencyCodes[XCEP_CONF_LATENCY_CODES];
+
+// Histogram i of a shard belongs to code slot i, the last one to the codes left without a slot
+static XCEP___t_LatencyCounters XCEP___g_LatencyShards[XCEP_CONF_LATENCY_SHARDS][XCEP_CONF_LATENCY_CODES + 1];
+static volatile long long XCEP___g_LatencyNextShard = 0;
+static volatile long long XCEP___g_LatencyTickRate = 0;
+
+static XCEP_t_Uint XCEP___LatencySlot(const XCEP_t_Int inCode) {
+	const XCEP_t_Uint vHash = ((XCEP_t_Uint)inCode * 2654435769u) >> 16;
+	for (XCEP_t_Uint i = 0; i < XCEP_CONF_LATENCY_CODES; ++i) {
+		const XCEP_t_Uint vSlot = (vHash + i) & (XCEP_CONF_LATENCY_CODES - 1);
+		if (XCEP___AtomicLoad(&XCEP___g_LatencyCodes[vSlot].state) == XCEP___LATENCY_EMPTY
+				&& XCEP___AtomicCas(&XCEP___g_LatencyCodes[vSlot].state, XCEP___LATENCY_EMPTY, XCEP___LATENCY_CLAIMED)) {
+			XCEP___g_LatencyCodes[vSlot].code = inCode;
+			XCEP___AtomicStore(&XCEP___g_LatencyCodes[vSlot].state, XCEP___LATENCY_READY);
+			return vSlot;
+		}
+		// Claimed by another thread, its code is needed: the same code could be claimed a second time further on
+		while (XCEP___AtomicLoad(&XCEP___g_LatencyCodes[vSlot].state) != XCEP___LATENCY_READY) { }
+		if (XCEP___g_LatencyCodes[vSlot].code == inCode) return vSlot;
+	}
+	return XCEP_CONF_LATENCY_CODES;
+}
+
+static XCEP_t_Uint XCEP___LatencyBucket(const unsigned long long inValue, const XCEP_t_Uint inBucketCount) {
+	if (inValue < 8) return (XCEP_t_Uint)inValue;
+#if defined(__GNUC__) || defined(__clang__)
+	const int vExponent = 63 - __builtin_clzll(inValue);
+#else
+	int vExponent = 3;
+	while (inValue >> (vExponent + 1)) ++vExponent;
+#endif
+	// The exponent picks 4 buckets, the 2 bits after the leading one pick among them
+	const XCEP_t_Uint vBucket = (XCEP_t_Uint)(vExponent - 2) * 4 + (XCEP_t_Uint)(inValue >> (vExponent - 2));
+	return vBucket < inBucketCount ? vBucket : inBucketCount - 1;
+}
+
+unsigned long long XCEP_LatencyBucketLow(const XCEP_t_Uint inBucket) {
+	if (inBucket < 8) return inBucket;
+	return (unsigned long long)(inBucket % 4 + 4) << (inBucket / 4 - 1);
+}
+
+void XCEP___LatencyCaught(XCEP_t_Context* inContext) {
+	const unsigned long long vTicks = XCEP___Ticks() - inContext->latency_start;
+
+	if (inContext->latency_shard == 0) {
+		inContext->latency_shard = (XCEP_t_Uint)(XCEP___AtomicAddRelaxed(&XCEP___g_LatencyNextShard, 1) % XCEP_CONF_LATENCY_SHARDS) + 1;
+	}
+	XCEP___t_LatencyCounters* vCounters =
+		&XCEP___g_LatencyShards[inContext->latency_shard - 1][XCEP___LatencySlot(inContext->last_exception.code)];
+	XCEP___AtomicAddRelaxed(&vCounters->count, 1);
+	XCEP___AtomicAddRelaxed(&vCounters->latency[XCEP___LatencyBucket(vTicks, XCEP_LATENCY_BUCKETS)], 1);
+	XCEP___AtomicAddRelaxed(&vCounters->hops[XCEP___LatencyBucket(inContext->latency_hops, XCEP_HOPS_BUCKETS)], 1);
+}
+
+// Sums the shards of one histogram, XCEP_FALSE when it has no sample
+static XCEP_t_Bool XCEP___LatencySum(const XCEP_t_Uint inSlot, XCEP_t_LatencyHistogram* outHistogram) {
+	memset(outHistogram, 0, sizeof(*outHistogram));
+	if (inSlot < XCEP_CONF_LATENCY_CODES) {
+		if (XCEP___AtomicLoad(&XCEP___g_LatencyCodes[inSlot].state) != XCEP___LATENCY_READY) return XCEP_FALSE;
+		outHistogram->code = XCEP___g_LatencyCodes[inSlot].code;
+	} else {
+		outHistogram->overflow = XCEP_TRUE;
+	}
+
+	for (int vShard = 0; vShard < XCEP_CONF_LATENCY_SHARDS; ++vShard) {
+		const XCEP___t_LatencyCounters* vCounters = &XCEP___g_LatencyShards[vShard][inSlot];
+		outHistogram->count += XCEP___AtomicLoadRelaxed(&vCounters->count);
+		for (int i = 0; i < XCEP_LATENCY_BUCKETS; ++i) {
+			outHistogram->latency[i] += XCEP___AtomicLoadRelaxed(&vCounters->latency[i]);
+		}
+		for (int i = 0; i < XCEP_HOPS_BUCKETS; ++i) {
+			outHistogram->hops[i] += XCEP___AtomicLoadRelaxed(&vCounters->hops[i]);
+		}
+	}
+	return outHistogram->count != 0;
+}
+
+size_t XCEP_LatencySnapshot(XCEP_t_LatencyHistogram* outHistograms, const size_t inCapacity) {
+	XCEP_t_LatencyHistogram vHistogram;
+	size_t vCount = 0;
+	for (XCEP_t_Uint vSlot = 0; vSlot <= XCEP_CONF_LATENCY_CODES; ++vSlot) {
+		if (!XCEP___LatencySum(vSlot, &vHistogram)) continue;
+		if (vCount < inCapacity) outHistograms[vCount] = vHistogram;
+		++vCount;
+	}
+	return vCount;
+}
+
+void XCEP_LatencyMerge(XCEP_t_LatencyHistogram* ioInto, const XCEP_t_LatencyHistogram* inFrom) {
+	ioInto->count += inFrom->count;
+	for (int i = 0; i < XCEP_LATENCY_BUCKETS; ++i) ioInto->latency[i] += inFrom->latency[i];
+	for (int i = 0; i < XCEP_HOPS_BUCKETS; ++i) ioInto->hops[i] += inFrom->hops[i];
+}
+
+unsigned long long XCEP_LatencyPercentile(const long long* inBuckets, const XCEP_t_Uint inBucketCount, const double inQuantile) {
+	long long vTotal = 0;
+	for (XCEP_t_Uint i = 0; i < inBucketCount; ++i) vTotal += inBuckets[i];
+	if (vTotal == 0) return 0;
+
+	// Rank of the sample, 1 based
+	const double vExactRank = inQuantile * (double)vTotal;
+	long long vRank = (long long)vExactRank;
+	if ((double)vRank < vExactRank || vRank < 1) ++vRank;
+	long long vSeen = 0;
+	for (XCEP_t_Uint i = 0; i < inBucketCount; ++i) {
+		vSeen += inBuckets[i];
+		if (vSeen >= vRank) return XCEP_LatencyBucketLow(i);
+	}
+	return XCEP_LatencyBucketLow(inBucketCount - 1);
+}
+
+long long XCEP_LatencyTickRate(void) {
+	long long vRate = XCEP___AtomicLoad(&XCEP___g_LatencyTickRate);
+	if (vRate != 0) return vRate;
+
+#if defined(XCEP___LATENCY_CLOCK)
+	vRate = 1000000000ll;
+#elif defined(XCEP___LATENCY_TSC)
+	// Racing first calls measure twice, any of the results is fine
+	const unsigned long long vStartNs = XCEP___LatencyNowNs();
+	const unsigned long long vStartTicks = XCEP___Ticks();
+	unsigned long long vElapsedNs;
+	while ((vElapsedNs = XCEP___LatencyNowNs() - vStartNs) < 5000000ull) { }
+	vRate = (long long)((double)(XCEP___Ticks() - vStartTicks) * 1e9 / (double)vElapsedNs);
+#else
+	unsigned long long vFrequency;
+	__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(vFrequency));
+	vRate = (long long)vFrequency;
+#endif
+	XCEP___AtomicStore(&XCEP___g_LatencyTickRate, vRate);
+	return vRate;
+}
+
+void XCEP_LatencyDump(FILE* inOutput) {
+	if (inOutput == NULL) inOutput = stderr;
+	const double vNsPerTick = 1e9 / (double)XCEP_LatencyTickRate();
+
+	fprintf(inOutput, "%-12s %10s %10s %10s %10s %10s %7s %7s %7s\n",
+		"code", "caught", "p50_ns", "p90_ns", "p99_ns", "max_ns", "hops50", "hops99", "hopsmax");
+	XCEP_t_LatencyHistogram vHistogram;
+	for (XCEP_t_Uint vSlot = 0; vSlot <= XCEP_CONF_LATENCY_CODES; ++vSlot) {
+		if (!XCEP___LatencySum(vSlot, &vHistogram)) continue;
+
+		char vCode[16];
+		if (vHistogram.overflow) snprintf(vCode, sizeof(vCode), "other");
+		else snprintf(vCode, sizeof(vCode), "%d", (int)vHistogram.code);
+		fprintf(inOutput, "%-12s %10lld %10.0f %10.0f %10.0f %10.0f %7llu %7llu %7llu\n",
+			vCode, vHistogram.count,
+			(double)XCEP_LatencyPercentile(vHistogram.latency, XCEP_LATENCY_BUCKETS, 0.5) * vNsPerTick,
+			(double)XCEP_LatencyPercentile(vHistogram.latency, XCEP_LATENCY_BUCKETS, 0.9) * vNsPerTick,
+			(double)XCEP_LatencyPercentile(vHistogram.latency, XCEP_LATENCY_BUCKETS, 0.99) * vNsPerTick,
+			(double)XCEP_LatencyPercentile(vHistogram.latency, XCEP_LATENCY_BUCKETS, 1.0) * vNsPerTick,
+			XCEP_LatencyPercentile(vHistogram.hops, XCEP_HOPS_BUCKETS, 0.5),
+			XCEP_LatencyPercentile(vHistogram.hops, XCEP_HOPS_BUCKETS, 0.99),
+			XCEP_LatencyPercentile(vHistogram.hops, XCEP_HOPS_BUCKETS, 1.0));
+	}
+	fflush(inOutput);
+}
 
-#define XCEP_Rethrow XCEP___Rethrow((XCEP_t_Frame*)&XCEP_v_state.frame)
+#endif
 
 // =========================================================
-// MARK: Short Commands
+// MARK: Handler Registry
 // =========================================================
 
-#if XCEP_CONF_ENABLE_SHORT_COMMANDS
-	typedef XCEP_t_Exception t_Exception;
-	typedef XCEP_t_ExceptionHandler t_ExceptionHandler;
-	#define NewException(_code, _msg) XCEP_NewException(_code, _msg)
-	#define Try XCEP_Try
-	#define Catch(_code) XCEP_Catch(_code)
-	#define CatchAll XCEP_CatchAll
-	#define CaughtException XCEP_CaughtException
-	#define Finally XCEP_Finally
-	#define EndTry XCEP_EndTry
-	#define Throw(_code, _msg) XCEP_Throw(_code, _msg)
-	#define Rethrow XCEP_Rethrow
-	#define PrintException(_text, _exception) XCEP_PrintException(_text, _exception)
-	#define SetUncaughtExceptionHandler(_handler) XCEP_SetUncaughtExceptionHandler(_handler)
+// Pointer sized compare-and-swap on a handler slot
+#define XCEP___HandlerCas(_slot, _expected, _desired) XCEP___AtomicCasPtr((void* volatile*)(_slot), (void*)(_expected), (void*)(_desired))
 
-	#if XCEP_CONF_ENABLE_THREAD_SAFE
-		#define SetThreadUncaughtExceptionHandler(_handler) XCEP_SetThreadUncaughtExceptionHandler(_handler)
-	#endif
+XCEP_t_ExceptionHandler XCEP_SetUncaughtExceptionHandler(const XCEP_t_ExceptionHandler inHandler) {
+	XCEP_t_ExceptionHandler vPrevious;
+	do {
+		vPrevious = XCEP___AtomicLoad(&XCEP_g_UncaughtExceptionHandler);
+	} while (!XCEP___HandlerCas(&XCEP_g_UncaughtExceptionHandler, vPrevious, inHandler));
+	return vPrevious;
+}
+
+#if XCEP_CONF_HANDLER_SUBSCRIBERS
+
+static XCEP_t_ExceptionHandler volatile XCEP___g_HandlerSubscribers[XCEP_CONF_HANDLER_SUBSCRIBERS];
+
+int XCEP_AddUncaughtExceptionHandler(const XCEP_t_ExceptionHandler inHandler) {
+	for (int i = 0; i < XCEP_CONF_HANDLER_SUBSCRIBERS; ++i) {
+		if (XCEP___AtomicLoad(&XCEP___g_HandlerSubscribers[i]) == NULL
+				&& XCEP___HandlerCas(&XCEP___g_HandlerSubscribers[i], NULL, inHandler)) {
+			return 0;
+		}
+	}
+	return -1;
+}
+
+XCEP_t_Bool XCEP_RemoveUncaughtExceptionHandler(const XCEP_t_ExceptionHandler inHandler) {
+	for (int i = 0; i < XCEP_CONF_HANDLER_SUBSCRIBERS; ++i) {
+		if (XCEP___AtomicLoad(&XCEP___g_HandlerSubscribers[i]) == inHandler
+				&& XCEP___HandlerCas(&XCEP___g_HandlerSubscribers[i], inHandler, NULL)) {
+			return XCEP_TRUE;
+		}
+	}
+	return XCEP_FALSE;
+}
 
 #endif
 
-#endif // XCEP_CDAD39BB4CBB62BD_H
+#if XCEP_CONF_HANDLER_TABLE_SIZE
 
-#ifdef XCEP_IMPLEMENTATION
-#undef XCEP_IMPLEMENTATION
+// A slot is claimed (EMPTY -> CLAIMED) by the first writer of a code and published (-> READY) once the code is
+// written, it is never released. Readers skip a CLAIMED slot: the code being inserted is not set yet for them.
+#define XCEP___HANDLER_EMPTY 0
+#define XCEP___HANDLER_CLAIMED 1
+#define XCEP___HANDLER_READY 2
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <assert.h>
-#include <string.h>
+typedef struct {
+	volatile long state;
+	XCEP_t_Int code;
+	XCEP_t_ExceptionHandler volatile handler;
+} XCEP___t_HandlerSlot;
 
-XCEP_THREAD_LOCAL XCEP_t_Frame* XCEP_g_Stack = NULL;
-XCEP_THREAD_LOCAL XCEP_t_Exception XCEP_g_LastException = {0};
-XCEP_t_ExceptionHandler XCEP_g_UncaughtExceptionHandler = NULL;
+static XCEP___t_HandlerSlot XCEP___g_HandlerTable[XCEP_CONF_HANDLER_TABLE_SIZE];
+
+static XCEP_t_Uint XCEP___HandlerHash(const XCEP_t_Int inCode) {
+	// Fibonacci hashing, nearby codes land in distant slots
+	return ((XCEP_t_Uint)inCode * 2654435769u) >> 16;
+}
+
+// Slot of inCode, claimed for it when inClaim is set and the code has none yet. NULL when not found or full.
+static XCEP___t_HandlerSlot* XCEP___HandlerFind(const XCEP_t_Int inCode, const XCEP_t_Bool inClaim) {
+	XCEP_t_Uint vIndex = XCEP___HandlerHash(inCode);
+	for (int i = 0; i < XCEP_CONF_HANDLER_TABLE_SIZE; ++i, ++vIndex) {
+		XCEP___t_HandlerSlot* vSlot = &XCEP___g_HandlerTable[vIndex & (XCEP_CONF_HANDLER_TABLE_SIZE - 1)];
+		long vState = XCEP___AtomicLoad(&vSlot->state);
+		if (vState == XCEP___HANDLER_EMPTY) {
+			if (!inClaim) return NULL;
+			if (XCEP___AtomicCas(&vSlot->state, XCEP___HANDLER_EMPTY, XCEP___HANDLER_CLAIMED)) {
+				vSlot->code = inCode;
+				XCEP___AtomicStore(&vSlot->state, XCEP___HANDLER_READY);
+				return vSlot;
+			}
+			vState = XCEP___AtomicLoad(&vSlot->state);
+		}
+		if (vState == XCEP___HANDLER_CLAIMED) {
+			if (!inClaim) continue;
+			// A writer must see the code of the slot: the same code could be claimed a second time further on
+			while ((vState = XCEP___AtomicLoad(&vSlot->state)) != XCEP___HANDLER_READY) { }
+		}
+		if (vSlot->code == inCode) return vSlot;
+	}
+	return NULL;
+}
+
+int XCEP_SetCodeUncaughtExceptionHandler(const XCEP_t_Int inCode, const XCEP_t_ExceptionHandler inHandler, XCEP_t_ExceptionHandler* outPrevious) {
+	XCEP___t_HandlerSlot* vSlot = XCEP___HandlerFind(inCode, inHandler != NULL);
+	if (vSlot == NULL) {
+		if (outPrevious) *outPrevious = NULL;
+		return inHandler != NULL ? -1 : 0;
+	}
+	XCEP_t_ExceptionHandler vPrevious;
+	do {
+		vPrevious = XCEP___AtomicLoad(&vSlot->handler);
+	} while (!XCEP___HandlerCas(&vSlot->handler, vPrevious, inHandler));
+	if (outPrevious) *outPrevious = vPrevious;
+	return 0;
+}
+
+XCEP_t_ExceptionHandler XCEP_GetCodeUncaughtExceptionHandler(const XCEP_t_Int inCode) {
+	const XCEP___t_HandlerSlot* vSlot = XCEP___HandlerFind(inCode, XCEP_FALSE);
+	return vSlot ? XCEP___AtomicLoad(&vSlot->handler) : NULL;
+}
 
-#if XCEP_CONF_ENABLE_THREAD_SAFE
-	XCEP_THREAD_LOCAL XCEP_t_ExceptionHandler XCEP_g_ThreadUncaughtExceptionHandler = NULL;
 #endif
 
-static void XCEP___UncaughtExceptionHandling(const XCEP_t_Exception *inException) {
-#if XCEP_CONF_ENABLE_THREAD_SAFE
-	if (XCEP_g_ThreadUncaughtExceptionHandler) {
-		XCEP_g_ThreadUncaughtExceptionHandler(inException);
-	} else {
+static XCEP___THROWING void XCEP___UncaughtExceptionHandling(XCEP_t_Context* inContext, const XCEP_t_Exception *inException) {
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+	XCEP___RecorderAppend(inContext, XCEP_RECORD_UNCAUGHT, inException);
 #endif
-		if (XCEP_g_UncaughtExceptionHandler) {
-			XCEP_g_UncaughtExceptionHandler(inException);
-		} else {
-			XCEP___PrintException(XCEP_FormatException("Uncaught inException"), inException);
-			exit(inException->code);
-		}
+#if XCEP_CONF_ENABLE_STATS
+	XCEP___StatsCount(inContext, inException->site, XCEP_STATS_UNCAUGHT);
+#endif
+#if XCEP_CONF_HANDLER_SUBSCRIBERS
+	for (int i = 0; i < XCEP_CONF_HANDLER_SUBSCRIBERS; ++i) {
+		const XCEP_t_ExceptionHandler vSubscriber = XCEP___AtomicLoad(&XCEP___g_HandlerSubscribers[i]);
+		if (vSubscriber) vSubscriber(inException);
+	}
+#endif
+
+	XCEP_t_ExceptionHandler vHandler = NULL;
 #if XCEP_CONF_ENABLE_THREAD_SAFE
+	vHandler = inContext->uncaught_handler;
+#else
+	(void)inContext;
+#endif
+#if XCEP_CONF_HANDLER_TABLE_SIZE
+	if (vHandler == NULL) vHandler = XCEP_GetCodeUncaughtExceptionHandler(inException->code);
+#endif
+	if (vHandler == NULL) vHandler = XCEP___AtomicLoad(&XCEP_g_UncaughtExceptionHandler);
+
+	if (vHandler) {
+		vHandler(inException);
+	} else {
+		XCEP___PrintException(XCEP_FormatException("Uncaught inException"), inException);
+	#if XCEP_CONF_ENABLE_ASYNC_LOG
+		XCEP_LogFlush();
+	#endif
+		exit(inException->code);
 	}
+#if XCEP_CONF_STRICT_THROW
+	// Throw is noreturn, there is nowhere to go back to
+	fprintf(stderr, "XCEP: an uncaught exception handler returned with XCEP_CONF_STRICT_THROW, aborting\n");
+	abort();
 #endif
 }
 
-void XCEP___PrintException(const char *inFormat, const XCEP_t_Exception *inException) {
+#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO
+#define XCEP___CAUSE_FORMAT "  Cause (%d): \"%s\"\n\tat %s(%s:%d)\n"
+#else
+#define XCEP___CAUSE_FORMAT "  Cause (%d): \"%s\"\n"
+#endif
+
+static void XCEP___PrintRecord(const char *inFormat, const XCEP_t_Exception *inException, const XCEP_t_Bool inWithBacktrace) {
+#if XCEP_CONF_ENABLE_ASYNC_LOG
+	XCEP___LogPush(inFormat, inException, inWithBacktrace);
+#else
+	#if XCEP_CONF_ENABLE_EXTRA_EXCEPTION_INFO && XCEP_CONF_ENABLE_COMPACT_SITES
+	const XCEP_t_SiteRecord* vSite = XCEP___SiteOrUnknown(inException->site_id);
+	fprintf(stderr, inFormat, inException->code, inException->message, vSite->function, vSite->file, vSite->line);
+	#else
 	fprintf(stderr, inFormat,
 			inException->code,
 			inException->message
@@ -266,39 +3138,571 @@ void XCEP___PrintException(const char *inFormat, const XCEP_t_Exception *inExcep
 			,inException->line
 		#endif
 	);
+	#endif
+	#if XCEP_CONF_BACKTRACE_DEPTH
+	if (inWithBacktrace) XCEP_PrintBacktrace();
+	#else
+	(void)inWithBacktrace;
+	#endif
+#endif
+}
+
+void XCEP___PrintException(const char *inFormat, const XCEP_t_Exception *inException) {
+#if XCEP_CONF_BACKTRACE_DEPTH
+	// Only when printing the last thrown exception of this thread, not one built by hand
+	const XCEP_t_Context* vContext = XCEP_GetContext();
+	XCEP___PrintRecord(inFormat, inException,
+		inException->code == vContext->backtrace_code && inException->message == vContext->backtrace_message);
+#else
+	XCEP___PrintRecord(inFormat, inException, XCEP_FALSE);
+#endif
+#if XCEP_CONF_CAUSE_DEPTH
+	// Same for the chain, the causes themselves are printed without theirs
+	const XCEP_t_Context* vChainContext = XCEP_GetContext();
+	if (inException->code == vChainContext->cause_code && inException->message == vChainContext->cause_message) {
+		XCEP_t_CauseIterator vIterator;
+		XCEP_CauseBegin(&vIterator);
+		for (const XCEP_t_Exception* vCause = XCEP_CauseNext(&vIterator); vCause != NULL; vCause = XCEP_CauseNext(&vIterator)) {
+			XCEP___PrintRecord(XCEP___CAUSE_FORMAT, vCause, XCEP_FALSE);
+		}
+	}
+#endif
+}
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+
+static volatile long XCEP___g_BacktraceSampling = XCEP_CONF_BACKTRACE_SAMPLING;
+
+// Largest gap accepted between two frame records, a bigger one means the chain is not made of frame pointers
+#define XCEP___BACKTRACE_MAX_FRAME_SIZE (1 << 20)
+
+void XCEP_SetBacktraceSampling(const XCEP_t_Uint inRate) {
+	XCEP___AtomicStore(&XCEP___g_BacktraceSampling, (long)inRate);
+}
+
+// Raw addresses only, symbolization is left to XCEP_PrintBacktrace. XCEP's own frames come first.
+static XCEP___NOINLINE void XCEP___CaptureBacktrace(XCEP_t_Context* inContext, const XCEP_t_Exception* inException) {
+	const long vRate = XCEP___AtomicLoad(&XCEP___g_BacktraceSampling);
+	inContext->backtrace_size = 0;
+	inContext->backtrace_code = inException->code;
+	inContext->backtrace_message = inException->message;
+	if (vRate <= 0) return;
+	if (inContext->backtrace_countdown > 0) {
+		inContext->backtrace_countdown--;
+		return;
+	}
+	inContext->backtrace_countdown = (XCEP_t_Uint)(vRate - 1);
+
+#if defined(_WIN32)
+	inContext->backtrace_size = (XCEP_t_Uint)RtlCaptureStackBackTrace(1, XCEP_CONF_BACKTRACE_DEPTH, inContext->backtrace, NULL);
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+	// Every frame record is { previous frame pointer, return address }
+	void** vFrame = (void**)__builtin_frame_address(0);
+	XCEP_t_Uint vCount = 0;
+	while (vFrame != NULL && vCount < XCEP_CONF_BACKTRACE_DEPTH) {
+		void** vNext = (void**)vFrame[0];
+		if (vFrame[1] == NULL) break;
+		inContext->backtrace[vCount++] = vFrame[1];
+
+		// The stack grows down: stop on anything not looking like the caller's frame record
+		if (vNext <= vFrame || (uintptr_t)vNext - (uintptr_t)vFrame > XCEP___BACKTRACE_MAX_FRAME_SIZE
+			|| ((uintptr_t)vNext & (sizeof(void*) - 1)) != 0) break;
+		vFrame = vNext;
+	}
+	inContext->backtrace_size = vCount;
+#elif defined(__GNUC__) || defined(__clang__)
+	inContext->backtrace[0] = __builtin_return_address(0);
+	inContext->backtrace_size = 1;
+#endif
+}
+
+void XCEP_PrintBacktrace(void) {
+	XCEP_t_Context* vContext = XCEP_GetContext();
+	if (vContext->backtrace_size == 0) return;
+
+	fflush(stderr);
+#if defined(XCEP___HAVE_BACKTRACE_SYMBOLS)
+	// Writes straight to the descriptor without allocating
+	backtrace_symbols_fd(vContext->backtrace, (int)vContext->backtrace_size, STDERR_FILENO);
+#else
+	for (XCEP_t_Uint i = 0; i < vContext->backtrace_size; ++i) {
+		fprintf(stderr, "\t#%u %p\n", (unsigned)i, vContext->backtrace[i]);
+	}
+#endif
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+
+static XCEP_t_Bool XCEP___FilterMatch(const XCEP_t_Filter* inFilter, const XCEP_t_Exception* inException) {
+	return XCEP___CodeIn(inException->code, inFilter->codes, inFilter->code_count)
+		|| (inFilter->has_range && inException->code >= inFilter->low && inException->code <= inFilter->high)
+		|| (inFilter->when != NULL && inFilter->when(inException));
+}
+
+// First phase, nothing is unwound yet: pops the TryFilter frames refusing inException and returns the frame to land in.
+// The outermost frame is always landed in, its EndTry reports the exception as uncaught like the plain chain does.
+static XCEP_t_Frame* XCEP___SearchFrame(XCEP_t_Context* inContext, const XCEP_t_Exception* inException) {
+	XCEP_t_Frame* vFrame = inContext->stack;
+	while (vFrame != NULL && vFrame->prev != NULL && vFrame->filter != NULL && !XCEP___FilterMatch(vFrame->filter, inException)) {
+		vFrame = vFrame->prev;
+	#if XCEP___TRACK_DEPTH
+		inContext->try_depth--;
+	#endif
+	}
+	inContext->stack = vFrame;
+	return vFrame;
 }
 
+#endif
+
 void XCEP___Thrown(const XCEP_t_Exception *inException) {
-	XCEP_t_Frame* vCurrentFrame = XCEP_g_Stack;
+	XCEP___ThrownCtx(XCEP_GetContext(), inException);
+}
+
+void XCEP___ThrownCtx(XCEP_t_Context* inContext, const XCEP_t_Exception *inException) {
+#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+	XCEP___RecorderAppend(inContext, XCEP_RECORD_THROW, inException);
+#endif
+#if XCEP_CONF_CAUSE_DEPTH
+	// Anything but ThrowWithCause starts without a chain
+	inContext->cause_length = inContext->cause_pending;
+	inContext->cause_pending = 0;
+	inContext->cause_code = inException->code;
+	inContext->cause_message = inException->message;
+#endif
+#if XCEP_CONF_ENABLE_LATENCY
+	inContext->latency_start = XCEP___Ticks();
+	inContext->latency_hops = 1;
+#endif
+	XCEP_t_Frame* vCurrentFrame = inContext->stack;
 
 	// Propagate inException when thrown in catch
+	if (vCurrentFrame != NULL && vCurrentFrame->state_flags.have_been_handled) {
+		vCurrentFrame->state_flags.thrown_in_catch = 1;
+	#if XCEP_CONF_ENABLE_STATS
+		// The exception being replaced has been caught, EndTry will only see the new one
+		if (!vCurrentFrame->state_flags.rethrow_requested) {
+			XCEP___StatsCount(inContext, inContext->last_exception.site, XCEP_STATS_CAUGHT);
+		}
+	#endif
+	}
+
+#if XCEP_CONF_ENABLE_ASYNC_LOG && XCEP_CONF_LOG_THROWS
+	XCEP___LogPush(XCEP_FormatException("Thrown"), inException, XCEP_FALSE);
+#endif
+
+#if XCEP_CONF_ENABLE_STATS
+	XCEP___StatsRegister(inException->site, inException->code);
+	XCEP___StatsCount(inContext, inException->site, XCEP_STATS_THROWN);
+#endif
+
+#if XCEP_CONF_BACKTRACE_DEPTH
+	XCEP___CaptureBacktrace(inContext, inException);
+#endif
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+	if (inException->type != NULL) {
+		XCEP___ResolveType((XCEP_t_Type*)inException->type);
+	}
+#endif
+
+#if XCEP_CONF_ENABLE_TWO_PHASE
+	vCurrentFrame = XCEP___SearchFrame(inContext, inException);
+	// Landing in a Try whose Catch runs a nested TryFilter the exception went past
 	if (vCurrentFrame != NULL && vCurrentFrame->state_flags.have_been_handled) {
 		vCurrentFrame->state_flags.thrown_in_catch = 1;
 	}
+#endif
 
 	if (vCurrentFrame) {
-		memcpy(&XCEP_g_LastException, inException, sizeof(XCEP_t_Exception));
-		longjmp(vCurrentFrame->env, XCEP_TRUE);
+		memcpy(&inContext->last_exception, inException, sizeof(XCEP_t_Exception));
+	#if XCEP_CONF_ENABLE_DEFER
+		XCEP___DeferUnwind(inContext, vCurrentFrame->defer_mark);
+	#endif
+		XCEP___LongJmp(vCurrentFrame->env);
 	}
 
-    XCEP___UncaughtExceptionHandling(inException);
+    XCEP___UncaughtExceptionHandling(inContext, inException);
 }
 
-void XCEP___EndTry(const XCEP_t_Frame *inCurrentFrame) {
-	XCEP_g_Stack = XCEP_g_Stack->prev;
+#if XCEP_CONF_CAUSE_DEPTH
+
+// Moves the chain of the exception inFrame handles back to the newest entries of the ring, inReserve entries
+// left free after it, and returns its length. Part of it written over by causes thrown since is dropped, oldest first.
+static XCEP_t_Uint XCEP___CauseRelink(XCEP_t_Context* inContext, const XCEP_t_Frame* inFrame, const XCEP_t_Uint inReserve) {
+	const XCEP_t_Uint vSince = (XCEP_t_Uint)(inContext->cause_count - inFrame->cause_mark);
+	XCEP_t_Uint vLength = inFrame->cause_chain;
+	if (vSince == 0) return vLength;
+
+	const XCEP_t_Uint vRoom = vSince + inReserve < XCEP_CONF_CAUSE_DEPTH ? XCEP_CONF_CAUSE_DEPTH - inReserve - vSince : 0;
+	if (vLength > vRoom) vLength = vRoom;
+
+	// Oldest first, a copy never lands on an entry still to be read
+	const XCEP_t_Uint vEnd = (inContext->cause_top + XCEP_CONF_CAUSE_DEPTH - vSince % XCEP_CONF_CAUSE_DEPTH) % XCEP_CONF_CAUSE_DEPTH;
+	for (XCEP_t_Uint i = vLength; i > 0; --i) {
+		XCEP_t_Cause* vCause = &inContext->causes[inContext->cause_top];
+		*vCause = inContext->causes[(vEnd + XCEP_CONF_CAUSE_DEPTH - i) % XCEP_CONF_CAUSE_DEPTH];
+		vCause->exception.message = vCause->message;
+		inContext->cause_top = (inContext->cause_top + 1) % XCEP_CONF_CAUSE_DEPTH;
+		inContext->cause_count++;
+	}
+	return vLength;
+}
+
+#endif
+
+void XCEP___EndTry(XCEP_t_Context* inContext, const XCEP_t_Frame *inCurrentFrame) {
+	inContext->stack = inContext->stack->prev;
+#if XCEP___TRACK_DEPTH
+	inContext->try_depth--;
+#endif
+
+#if XCEP_CONF_ENABLE_DEFER
+	// Cleanups left by the Try body or the Catch blocks end with the block
+	XCEP___DeferUnwind(inContext, inCurrentFrame->defer_mark);
+#endif
 
 	const XCEP_t_Bool vShouldPropagate =
 			inCurrentFrame->state_flags.thrown == XCEP_TRUE && inCurrentFrame->state_flags.have_been_handled == XCEP_FALSE
 			|| (inCurrentFrame->state_flags.rethrow_requested || inCurrentFrame->state_flags.thrown_in_catch);
 
+	if (inCurrentFrame->state_flags.have_been_handled) {
+	#if XCEP_CONF_MESSAGE_ARENA_SIZE
+		XCEP___PinMessage(inContext, inCurrentFrame->handled.message, -1);
+	#endif
+		// A Try nested in the Catch may have caught another exception since
+		if (inCurrentFrame->state_flags.rethrow_requested && !inCurrentFrame->state_flags.thrown_in_catch) {
+			inContext->last_exception = inCurrentFrame->handled;
+		#if XCEP_CONF_CAUSE_DEPTH
+			inContext->cause_length = XCEP___CauseRelink(inContext, inCurrentFrame, 0);
+			inContext->cause_code = inCurrentFrame->handled.code;
+			inContext->cause_message = inCurrentFrame->handled.message;
+		#endif
+		}
+	}
+
+#if XCEP_CONF_ENABLE_STATS
+	if (inCurrentFrame->state_flags.have_been_handled && !inCurrentFrame->state_flags.thrown_in_catch) {
+		XCEP___StatsCount(inContext, inContext->last_exception.site,
+			inCurrentFrame->state_flags.rethrow_requested ? XCEP_STATS_RETHROWN : XCEP_STATS_CAUGHT);
+	}
+#endif
+
 	if (vShouldPropagate) {
-		if (XCEP_g_Stack) {
-			longjmp(XCEP_g_Stack->env, XCEP_TRUE);
+	#if XCEP_CONF_ENABLE_FLIGHT_RECORDER
+		if (inCurrentFrame->state_flags.rethrow_requested && !inCurrentFrame->state_flags.thrown_in_catch) {
+			XCEP___RecorderAppend(inContext, XCEP_RECORD_RETHROW, &inContext->last_exception);
+		}
+	#endif
+	#if XCEP_CONF_ENABLE_TWO_PHASE
+		XCEP___SearchFrame(inContext, &inContext->last_exception);
+	#endif
+		if (inContext->stack) {
+			// Leaving a Try nested in a Catch replaces the exception handled by the enclosing Try, as a Throw would
+			if (inContext->stack->state_flags.have_been_handled) {
+				inContext->stack->state_flags.thrown_in_catch = 1;
+			}
+		#if XCEP_CONF_ENABLE_DEFER
+			XCEP___DeferUnwind(inContext, inContext->stack->defer_mark);
+		#endif
+		#if XCEP_CONF_ENABLE_LATENCY
+			// A Rethrow dispatches the handled exception again, timed from here
+			if (inCurrentFrame->state_flags.rethrow_requested && !inCurrentFrame->state_flags.thrown_in_catch) {
+				inContext->latency_start = XCEP___Ticks();
+				inContext->latency_hops = 0;
+			}
+			inContext->latency_hops++;
+		#endif
+			XCEP___LongJmp(inContext->stack->env);
+		}
+        XCEP___UncaughtExceptionHandling(inContext, &inContext->last_exception);
+	}
+}
+
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+
+const char* XCEP___FormatMessage(XCEP_t_Context* inContext, const char* inFormat, ...) {
+	XCEP_t_Uint vSlot = inContext->message_slot;
+	for (XCEP_t_Uint vTried = 0; inContext->message_pins[vSlot] != 0; vSlot = (vSlot + 1) % XCEP___MESSAGE_SLOTS) {
+		if (++vTried == XCEP___MESSAGE_SLOTS) return inFormat;
+	}
+	char* vMessage = inContext->message_arena + (size_t)vSlot * XCEP_CONF_MESSAGE_MAX_SIZE;
+	inContext->message_slot = (vSlot + 1) % XCEP___MESSAGE_SLOTS;
+
+	va_list vArgs;
+	va_start(vArgs, inFormat);
+	const int vLength = vsnprintf(vMessage, XCEP_CONF_MESSAGE_MAX_SIZE, inFormat, vArgs);
+	va_end(vArgs);
+
+	if (vLength < 0) {
+		vMessage[0] = '\0';
+	}
+#if XCEP_CONF_MESSAGE_TRUNCATION == XCEP_TRUNCATE_ELLIPSIS
+	else if (vLength >= XCEP_CONF_MESSAGE_MAX_SIZE) {
+		memcpy(vMessage + XCEP_CONF_MESSAGE_MAX_SIZE - 4, "...", 3);
+	}
+#endif
+
+	return vMessage;
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_EXCEPTION_TYPES
+
+void XCEP___ResolveType(XCEP_t_Type* inType) {
+	if (XCEP___AtomicLoad(&inType->state) == XCEP___TYPE_RESOLVED) return;
+
+	XCEP___ResolveType(inType->parent);
+
+	if (XCEP___AtomicCas(&inType->state, XCEP___TYPE_UNRESOLVED, XCEP___TYPE_RESOLVING)) {
+		const XCEP_t_Uint vDepth = inType->parent->depth + 1;
+		if (XCEP___UNLIKELY(vDepth >= XCEP_CONF_TYPE_MAX_DEPTH)) {
+			// Left unresolved, every throw of the type fails the same way instead of overflowing display
+			XCEP___AtomicStore(&inType->state, XCEP___TYPE_UNRESOLVED);
+			XCEP___ThrownCtx(XCEP_GetContext(), &XCEP_NewException(XCEP_ERR_TYPE_DEPTH, "Exception type hierarchy deeper than XCEP_CONF_TYPE_MAX_DEPTH"));
+		}
+		memcpy(inType->display, inType->parent->display, sizeof(inType->display[0]) * vDepth);
+		inType->display[vDepth] = inType;
+		inType->depth = vDepth;
+		XCEP___AtomicStore(&inType->state, XCEP___TYPE_RESOLVED);
+	} else {
+		// Another thread is copying the display, it only takes a few stores
+		while (XCEP___AtomicLoad(&inType->state) == XCEP___TYPE_RESOLVING) { }
+		// Put back by a hierarchy too deep, fail the same way
+		if (XCEP___AtomicLoad(&inType->state) != XCEP___TYPE_RESOLVED) XCEP___ResolveType(inType);
+	}
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_DEFER
+
+void XCEP___DeferUnwind(XCEP_t_Context* inContext, const XCEP_t_Uint inMark) {
+	// Popped before running so a cleanup that throws is not run twice
+	while (inContext->defer_top > inMark) {
+		const XCEP_t_Deferred vEntry = inContext->defer_stack[--inContext->defer_top];
+		vEntry.func(vEntry.arg);
+	}
+}
+
+void XCEP___DeferOverflow(XCEP_t_Context* inContext, const XCEP_t_DeferFunc inFunc, void* inArg) {
+	inFunc(inArg);
+	XCEP___ThrownCtx(inContext, &XCEP_NewException(XCEP_ERR_DEFER_OVERFLOW, "Defer stack overflow, increase XCEP_CONF_DEFER_STACK_SIZE"));
+}
+
+#endif
+
+#if XCEP_CONF_ENABLE_SIGNALS
+
+#include <signal.h>
+#include <sys/mman.h>
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+	#include <pthread.h>
+#endif
+
+static const int XCEP___g_Signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+static const XCEP_t_Int XCEP___g_SignalCodes[] = { XCEP_ERR_SEGFAULT, XCEP_ERR_BUS_ERROR, XCEP_ERR_FPE, XCEP_ERR_ILLEGAL_INSTRUCTION };
+static const char* const XCEP___g_SignalMessages[] = { "Segmentation fault", "Bus error", "Floating point exception", "Illegal instruction" };
+#define XCEP___SIGNAL_COUNT (sizeof(XCEP___g_Signals) / sizeof(XCEP___g_Signals[0]))
+
+static struct sigaction XCEP___g_SignalPrevious[XCEP___SIGNAL_COUNT];
+static volatile long XCEP___g_SignalsInstalled = 0;
+// Mapped by XCEP_SignalsThreadInit, threads never handling a fault do not pay for a stack in their TLS block
+static XCEP_THREAD_LOCAL void* XCEP___g_SignalStack XCEP___TLS_MODEL = NULL;
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+static pthread_key_t XCEP___g_SignalStackKey;
+static pthread_once_t XCEP___g_SignalStackOnce = PTHREAD_ONCE_INIT;
+static int XCEP___g_SignalStackKeyCreated = 0;
+#endif
+
+static void XCEP___SignalHandler(const int inSignal, siginfo_t* inInfo, void* inUserContext) {
+	XCEP_t_Context* vContext = XCEP_GetContext();
+	size_t vIndex = 0;
+	while (XCEP___g_Signals[vIndex] != inSignal) vIndex++;
+
+	if (vContext->stack == NULL) {
+		const struct sigaction* vPrevious = &XCEP___g_SignalPrevious[vIndex];
+		if (vPrevious->sa_flags & SA_SIGINFO) {
+			vPrevious->sa_sigaction(inSignal, inInfo, inUserContext);
+			return;
+		}
+		if (vPrevious->sa_handler != SIG_DFL && vPrevious->sa_handler != SIG_IGN) {
+			vPrevious->sa_handler(inSignal);
+			return;
+		}
+		// Returning runs the faulting instruction again, now with the default action
+		struct sigaction vDefault;
+		memset(&vDefault, 0, sizeof(vDefault));
+		vDefault.sa_handler = SIG_DFL;
+		sigaction(inSignal, &vDefault, NULL);
+		if (inInfo->si_code <= 0) raise(inSignal); // Sent by kill or raise, nothing would fault again
+		return;
+	}
+
+	XCEP_t_Exception vException = XCEP_NewException(XCEP___g_SignalCodes[vIndex], XCEP___g_SignalMessages[vIndex]);
+#if XCEP_CONF_PAYLOAD_SIZE
+	const XCEP_t_SignalInfo vInfo = { inSignal, inInfo->si_code, inInfo->si_addr };
+	if (sizeof(vInfo) <= XCEP_CONF_PAYLOAD_SIZE) {
+		vException.payload_size = (XCEP_t_Uint)sizeof(vInfo);
+		memcpy(vContext->payload.bytes, &vInfo, sizeof(vInfo));
+	}
+#endif
+
+#if XCEP___JUMP_BACKEND != XCEP_JUMP_BACKEND_SIGSETJMP
+	// The signal stays blocked after leaving its handler with a plain jump
+	sigset_t vUnblock;
+	sigemptyset(&vUnblock);
+	sigaddset(&vUnblock, inSignal);
+	#if XCEP_CONF_ENABLE_THREAD_SAFE
+		pthread_sigmask(SIG_UNBLOCK, &vUnblock, NULL);
+	#else
+		sigprocmask(SIG_UNBLOCK, &vUnblock, NULL);
+	#endif
+#endif
+	XCEP___ThrownCtx(vContext, &vException);
+}
+
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+
+// Key destructor, runs on the exiting thread: the stack is disabled before being unmapped
+static void XCEP___SignalStackRelease(void* inStack) {
+	stack_t vDisable;
+	memset(&vDisable, 0, sizeof(vDisable));
+	vDisable.ss_flags = SS_DISABLE;
+	sigaltstack(&vDisable, NULL);
+	munmap(inStack, XCEP_CONF_SIGNAL_STACK_SIZE);
+	XCEP___g_SignalStack = NULL;
+}
+
+static void XCEP___SignalStackKeyCreate(void) {
+	XCEP___g_SignalStackKeyCreated = pthread_key_create(&XCEP___g_SignalStackKey, XCEP___SignalStackRelease) == 0;
+}
+
+#endif
+
+int XCEP_SignalsThreadInit(void) {
+	if (XCEP___g_SignalStack != NULL) return 0;
+	void* vMapping = mmap(NULL, XCEP_CONF_SIGNAL_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (vMapping == MAP_FAILED) return -1;
+
+	stack_t vStack;
+	memset(&vStack, 0, sizeof(vStack));
+	vStack.ss_sp = vMapping;
+	vStack.ss_size = XCEP_CONF_SIGNAL_STACK_SIZE;
+	if (sigaltstack(&vStack, NULL) != 0) {
+		munmap(vMapping, XCEP_CONF_SIGNAL_STACK_SIZE);
+		return -1;
+	}
+#if XCEP_CONF_ENABLE_THREAD_SAFE
+	// Out of keys, the stack still works but outlives its thread
+	pthread_once(&XCEP___g_SignalStackOnce, XCEP___SignalStackKeyCreate);
+	if (XCEP___g_SignalStackKeyCreated) pthread_setspecific(XCEP___g_SignalStackKey, vMapping);
+#endif
+	XCEP___g_SignalStack = vMapping;
+	return 0;
+}
+
+int XCEP_SignalsInstall(void) {
+	// Installing twice would save the XCEP handler as the previous one
+	if (XCEP___AtomicLoad(&XCEP___g_SignalsInstalled)) return 0;
+	if (XCEP_SignalsThreadInit() != 0) return -1;
+
+	struct sigaction vAction;
+	memset(&vAction, 0, sizeof(vAction));
+	vAction.sa_sigaction = XCEP___SignalHandler;
+	vAction.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&vAction.sa_mask);
+	for (size_t i = 0; i < XCEP___SIGNAL_COUNT; ++i) {
+		if (sigaction(XCEP___g_Signals[i], &vAction, &XCEP___g_SignalPrevious[i]) != 0) {
+			while (i-- > 0) sigaction(XCEP___g_Signals[i], &XCEP___g_SignalPrevious[i], NULL);
+			return -1;
 		}
-        XCEP___UncaughtExceptionHandling(&XCEP_g_LastException);
 	}
+	XCEP___AtomicStore(&XCEP___g_SignalsInstalled, 1);
+	return 0;
+}
+
+void XCEP_SignalsUninstall(void) {
+	if (!XCEP___AtomicLoad(&XCEP___g_SignalsInstalled)) return;
+	for (size_t i = 0; i < XCEP___SIGNAL_COUNT; ++i) {
+		sigaction(XCEP___g_Signals[i], &XCEP___g_SignalPrevious[i], NULL);
+	}
+	XCEP___AtomicStore(&XCEP___g_SignalsInstalled, 0);
+}
+
+#endif
+
+void XCEP_CaptureException(XCEP_t_ExceptionPtr* outCaptured) {
+	const XCEP_t_Context* vContext = XCEP_GetContext();
+	const char* vMessage = vContext->last_exception.message ? vContext->last_exception.message : "";
+	size_t vLength = strlen(vMessage);
+	if (vLength >= XCEP_CONF_CAPTURED_MESSAGE_SIZE) vLength = XCEP_CONF_CAPTURED_MESSAGE_SIZE - 1;
+
+	outCaptured->has_exception = XCEP_TRUE;
+	outCaptured->exception = vContext->last_exception;
+	// Pointing at outCaptured->message would dangle once the value is copied
+	outCaptured->exception.message = NULL;
+	memcpy(outCaptured->message, vMessage, vLength);
+	outCaptured->message[vLength] = '\0';
+#if XCEP_CONF_PAYLOAD_SIZE
+	memcpy(outCaptured->payload.bytes, vContext->payload.bytes, vContext->last_exception.payload_size);
+#endif
+}
+
+void XCEP_RethrowCaptured(const XCEP_t_ExceptionPtr* inCaptured) {
+	XCEP_t_Context* vContext = XCEP_GetContext();
+	XCEP_t_Exception vException = inCaptured->exception;
+#if XCEP_CONF_MESSAGE_ARENA_SIZE
+	// The copy in the arena does not depend on inCaptured staying alive, with every slot pinned the text is used in place
+	static const char vFormat[] = "%s";
+	vException.message = XCEP___FormatMessage(vContext, vFormat, inCaptured->message);
+	if (vException.message == vFormat) vException.message = inCaptured->message;
+#else
+	vException.message = inCaptured->message;
+#endif
+#if XCEP_CONF_PAYLOAD_SIZE
+	memcpy(vContext->payload.bytes, inCaptured->payload.bytes, vException.payload_size);
+#endif
+	XCEP___ThrownCtx(vContext, &vException);
+}
+
+#if XCEP_CONF_CAUSE_DEPTH
+
+void XCEP___ThrownWithCause(XCEP_t_Context* inContext, const XCEP_t_Exception* inException) {
+	// The innermost frame in its Catch, a Finally alone does not handle anything. Exceptions thrown and caught
+	// within that Catch have replaced last_exception and the chain, the frame kept its own.
+	const XCEP_t_Frame* vFrame = inContext->stack;
+	while (vFrame != NULL && !vFrame->state_flags.have_been_handled) {
+		vFrame = vFrame->prev;
+	}
+
+	if (vFrame != NULL) {
+		const XCEP_t_Uint vChain = XCEP___CauseRelink(inContext, vFrame, 1);
+		XCEP_t_Cause* vCause = &inContext->causes[inContext->cause_top];
+		const char* vMessage = vFrame->handled.message ? vFrame->handled.message : "";
+		size_t vLength = strlen(vMessage);
+		if (vLength >= XCEP_CONF_CAUSE_MESSAGE_SIZE) vLength = XCEP_CONF_CAUSE_MESSAGE_SIZE - 1;
+
+		// memmove, the message can be the text of the slot being reused
+		memmove(vCause->message, vMessage, vLength);
+		vCause->message[vLength] = '\0';
+		vCause->exception = vFrame->handled;
+		vCause->exception.message = vCause->message;
+
+		// The slot written was the oldest one, dropped from a chain already CAUSE_DEPTH long
+		inContext->cause_top = (inContext->cause_top + 1) % XCEP_CONF_CAUSE_DEPTH;
+		inContext->cause_count++;
+		inContext->cause_pending = vChain < XCEP_CONF_CAUSE_DEPTH ? vChain + 1 : XCEP_CONF_CAUSE_DEPTH;
+	}
+
+	XCEP___ThrownCtx(inContext, inException);
 }
 
+#endif
+
 void XCEP___Rethrow(XCEP_t_Frame* inCurrentFrame) {
 	assert(inCurrentFrame->state_flags.have_been_handled == XCEP_TRUE && "Rethrow can only be used inside a Catch or CatchAll block.");
 	inCurrentFrame->state_flags.rethrow_requested = XCEP_TRUE;